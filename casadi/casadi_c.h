@@ -39,7 +39,11 @@ extern "C" {
 
 // Integer type
 #ifndef casadi_int
+#ifdef CASADI_INT32
+#define casadi_int int
+#else
 #define casadi_int long long int
+#endif
 #endif // casadi_int
 
 #endif // CASADI_CASADI_HPP
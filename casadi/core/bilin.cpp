@@ -123,10 +123,22 @@ namespace casadi {
   void Bilin::generate(CodeGenerator& g,
                        const std::vector<casadi_int>& arg,
                        const std::vector<casadi_int>& res) const {
-    g << g.workel(res[0]) << " = "
-      << g.bilin(g.work(arg[0], dep(0).nnz()), dep(0).sparsity(),
-                 g.work(arg[1], dep(1).nnz()),
-                 g.work(arg[2], dep(2).nnz())) << ";\n";
+    std::string A = g.work(arg[0], dep(0).nnz()), x = g.work(arg[1], dep(1).nnz()),
+      y = g.work(arg[2], dep(2).nnz()), r = g.workel(res[0]);
+    casadi_int m = dep(0).size1(), n = dep(0).size2();
+
+    // Dense A: x'*A*y as one CBLAS dot product per column of A
+    bool blas = dep(0).sparsity().is_dense() && g.use_cblas(m*n);
+    if (blas) {
+      g.local("i", "casadi_int");
+      g << "#ifdef CASADI_WITH_CBLAS\n";
+      g << r << " = 0;\n";
+      g << "for (i=0; i<" << n << "; ++i) " << r << " += " << y << "[i]*cblas_ddot("
+        << m << ", " << A << "+i*" << m << ", 1, " << x << ", 1);\n";
+      g << "#else\n";
+    }
+    g << r << " = " << g.bilin(A, dep(0).sparsity(), x, y) << ";\n";
+    if (blas) g << "#endif\n";
   }
 
 } // namespace casadi
@@ -118,6 +118,9 @@ namespace casadi {
     /** \brief Get required length of w field */
     size_t sz_w() const override;
 
+    /** \brief Get required length of w field in generated code */
+    size_t codegen_sz_w(const CodeGenerator& g) const override;
+
     /** \brief Serialize an object without type information */
     void serialize_body(SerializingStream& s) const override;
 
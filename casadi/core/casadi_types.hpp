@@ -27,7 +27,12 @@
 #define CASADI_TYPES_HPP
 
 #ifndef CASADI_INT_TYPE
+#ifdef CASADI_INT32
+// 32-bit indices: halves the memory footprint of sparsity patterns
+#define CASADI_INT_TYPE int
+#else // CASADI_INT32
 #define CASADI_INT_TYPE long long int
+#endif // CASADI_INT32
 #endif // CASADI_INT_TYPE
 
 
@@ -40,11 +40,13 @@ namespace casadi {
     this->mex = false;
     this->cpp = false;
     this->main = false;
+    this->benchmark = false;
     this->casadi_real_type = "double";
     this->casadi_int_type = CASADI_INT_TYPE_STR;
     this->codegen_scalars = false;
     this->with_header = false;
     this->with_mem = false;
+    this->with_batch = false;
     this->with_export = true;
     this->with_import = false;
     this->include_math = true;
@@ -54,6 +56,10 @@ namespace casadi {
     bool prefix_set = false;
     this->prefix = "";
     avoid_stack_ = false;
+    this->thread_safe = false;
+    this->split_size = 0;
+    this->reroll = 0;
+    this->blas_threshold = 0;
     indent_ = 2;
 
     // Read options
@@ -68,8 +74,12 @@ namespace casadi {
         this->cpp = e.second;
       } else if (e.first=="main") {
         this->main = e.second;
+      } else if (e.first=="benchmark") {
+        this->benchmark = e.second;
       } else if (e.first=="casadi_real") {
         this->casadi_real_type = e.second.to_string();
+      } else if (e.first=="casadi_real_solve") {
+        this->casadi_real_solve_type = e.second.to_string();
       }  else if (e.first=="casadi_int") {
         this->casadi_int_type = e.second.to_string();
       } else if (e.first=="codegen_scalars") {
@@ -78,6 +88,8 @@ namespace casadi {
         this->with_header = e.second;
       } else if (e.first=="with_mem") {
         this->with_mem = e.second;
+      } else if (e.first=="with_batch") {
+        this->with_batch = e.second;
       } else if (e.first=="with_export") {
         this->with_export = e.second;
       } else if (e.first=="with_import") {
@@ -95,6 +107,17 @@ namespace casadi {
         casadi_assert_dev(indent_>=0);
       } else if (e.first=="avoid_stack") {
         avoid_stack_ = e.second;
+      } else if (e.first=="thread_safe") {
+        this->thread_safe = e.second;
+      } else if (e.first=="split_size") {
+        this->split_size = e.second;
+        casadi_assert(this->split_size>=0, "Option 'split_size' must be non-negative");
+      } else if (e.first=="reroll") {
+        this->reroll = e.second;
+        casadi_assert(this->reroll>=0, "Option 'reroll' must be non-negative");
+      } else if (e.first=="blas_threshold") {
+        this->blas_threshold = e.second;
+        casadi_assert(this->blas_threshold>=0, "Option 'blas_threshold' must be non-negative");
       } else if (e.first=="prefix") {
         this->prefix = e.second.to_string();
         prefix_set = true;
@@ -103,6 +126,15 @@ namespace casadi {
       }
     }
 
+    // Linear solves in the same precision unless requested otherwise
+    if (this->casadi_real_solve_type.empty()) {
+      this->casadi_real_solve_type = this->casadi_real_type;
+    } else if (this->casadi_real_solve_type!=this->casadi_real_type) {
+      casadi_assert(this->casadi_real_solve_type=="float"
+        || this->casadi_real_solve_type=="double",
+        "Option 'casadi_real_solve' must be \"float\" or \"double\"");
+    }
+
     // If real_min is not specified, make an educated guess
     if (this->real_min.empty()) {
       std::stringstream ss;
@@ -142,12 +174,19 @@ namespace casadi {
     // Make sure that the base name is sane
     casadi_assert_dev(Function::check_name(this->name));
 
+    // Benchmark driver needs clock_gettime and syscall, before any other include
+    if (this->benchmark) {
+      this->includes << "#if defined(__linux__) && !defined(_GNU_SOURCE)\n"
+                     << "#define _GNU_SOURCE\n"
+                     << "#endif\n";
+    }
+
     // Includes needed
     if (this->include_math) add_include("math.h");
-    if (this->main) add_include("stdio.h");
+    if (this->main || this->benchmark) add_include("stdio.h");
 
     // Mex and main need string.h
-    if (this->mex || this->main) {
+    if (this->mex || this->main || this->benchmark) {
       add_include("string.h");
     }
 
@@ -264,30 +303,60 @@ namespace casadi {
       std::string alloc_mem = shorthand(name + "_alloc_mem");
       std::string init_mem = shorthand(name + "_init_mem");
 
-      auxiliaries << "static int " << mem_counter  << " = 0;\n";
-      auxiliaries << "static int " << stack_counter  << " = -1;\n";
-      auxiliaries << "static int " << stack << "[CASADI_MAX_NUM_THREADS];\n";
-      auxiliaries << "static " << f->codegen_mem_type() <<
-               " *" << mem_array << "[CASADI_MAX_NUM_THREADS];\n\n";
-
-      *this << "int " << shorthand(name + "_checkout") << "(void) {\n";
-      *this << "int mid;\n";
-      *this << "if (" << stack_counter << ">=0) {\n";
-      *this << "return " << stack << "[" << stack_counter << "--];\n";
-      *this << "} else {\n";
-      *this << "if (" << mem_counter << "==CASADI_MAX_NUM_THREADS) return -1;\n";
-      *this << "mid = " << alloc_mem << "();\n";
-      *this << "if (mid<0) return -1;\n";
-      *this << "if(" << init_mem << "(mid)) return -1;\n";
-      *this << "return mid;\n";
-      *this << "}\n";
-
-      *this << "return " << stack << "[" << stack_counter << "--];\n";
-      *this << "}\n\n";
-
-      *this << "void " << shorthand(name + "_release") << "(int mem) {\n";
-      *this << stack << "[++" << stack_counter << "] = mem;\n";
-      *this << "}\n\n";
+      if (this->thread_safe) {
+        // Memory objects are claimed and released with atomic operations on their state
+        std::string mem_state = shorthand(name + "_mem_state");
+        auxiliaries << "static casadi_atomic_int " << mem_counter  << ";\n";
+        auxiliaries << "static casadi_atomic_int " << mem_state
+                    << "[CASADI_MAX_NUM_THREADS];\n";
+        auxiliaries << "static " << f->codegen_mem_type() <<
+                 " *" << mem_array << "[CASADI_MAX_NUM_THREADS];\n\n";
+
+        // State: 0 never released, 1 in use, 2 released
+        *this << "int " << shorthand(name + "_checkout") << "(void) {\n";
+        *this << "int mid, n, s;\n";
+        *this << "n = casadi_atomic_load(&" << mem_counter << ");\n";
+        *this << "if (n>CASADI_MAX_NUM_THREADS) n = CASADI_MAX_NUM_THREADS;\n";
+        *this << "for (mid=0; mid<n; ++mid) {\n";
+        *this << "s = 2;\n";
+        *this << "if (casadi_atomic_cas(&" << mem_state << "[mid], &s, 1)) return mid;\n";
+        *this << "}\n";
+        *this << "mid = " << alloc_mem << "();\n";
+        *this << "if (mid<0 || mid>=CASADI_MAX_NUM_THREADS) return -1;\n";
+        *this << "if (" << init_mem << "(mid)) return -1;\n";
+        *this << "casadi_atomic_store(&" << mem_state << "[mid], 1);\n";
+        *this << "return mid;\n";
+        *this << "}\n\n";
+
+        *this << "void " << shorthand(name + "_release") << "(int mem) {\n";
+        *this << "casadi_atomic_store(&" << mem_state << "[mem], 2);\n";
+        *this << "}\n\n";
+      } else {
+        auxiliaries << "static int " << mem_counter  << " = 0;\n";
+        auxiliaries << "static int " << stack_counter  << " = -1;\n";
+        auxiliaries << "static int " << stack << "[CASADI_MAX_NUM_THREADS];\n";
+        auxiliaries << "static " << f->codegen_mem_type() <<
+                 " *" << mem_array << "[CASADI_MAX_NUM_THREADS];\n\n";
+
+        *this << "int " << shorthand(name + "_checkout") << "(void) {\n";
+        *this << "int mid;\n";
+        *this << "if (" << stack_counter << ">=0) {\n";
+        *this << "return " << stack << "[" << stack_counter << "--];\n";
+        *this << "} else {\n";
+        *this << "if (" << mem_counter << "==CASADI_MAX_NUM_THREADS) return -1;\n";
+        *this << "mid = " << alloc_mem << "();\n";
+        *this << "if (mid<0) return -1;\n";
+        *this << "if(" << init_mem << "(mid)) return -1;\n";
+        *this << "return mid;\n";
+        *this << "}\n";
+
+        *this << "return " << stack << "[" << stack_counter << "--];\n";
+        *this << "}\n\n";
+
+        *this << "void " << shorthand(name + "_release") << "(int mem) {\n";
+        *this << stack << "[++" << stack_counter << "] = mem;\n";
+        *this << "}\n\n";
+      }
     }
 
     return fname;
@@ -302,6 +371,15 @@ namespace casadi {
           << "return " << codegen_name <<  "(arg, res, iw, w, mem);\n"
           << "}\n\n";
 
+    // Batch entry point, structure-of-arrays layout
+    if (this->with_batch && f->has_codegen_batch()) {
+      *this << declare("int " + f.name() + "_batch(const casadi_real** arg, casadi_real** res, "
+                       "casadi_int n)") << " {\n";
+      f->codegen_batch_body(*this);
+      *this << "return 0;\n"
+            << "}\n\n";
+    }
+
     // Generate meta information
     f->codegen_meta(*this);
 
@@ -320,6 +398,71 @@ namespace casadi {
     this->exposed_fname.push_back(f.name());
   }
 
+  void CodeGenerator::add_precision_check(const Function& f,
+                                          const std::vector<std::vector<DM> >& samples) {
+    casadi_assert(!samples.empty(), "add_precision_check: No samples given");
+    casadi_assert(f.nnz_out()>0, "add_precision_check: Function has no outputs");
+
+    // Double precision reference
+    vector<double> x, y;
+    for (auto&& s : samples) {
+      casadi_assert(s.size()==f.n_in(), "add_precision_check: Expected " + str(f.n_in())
+        + " inputs per sample, got " + str(s.size()));
+      vector<DM> arg(s.size());
+      for (casadi_int i=0; i<s.size(); ++i) {
+        casadi_assert(s[i].size()==f.size_in(i), "add_precision_check: Dimension mismatch for "
+          "input " + str(i) + ": " + s[i].dim() + " vs " + f.sparsity_in(i).dim());
+        arg[i] = DM::project(s[i], f.sparsity_in(i));
+        x.insert(x.end(), arg[i].nonzeros().begin(), arg[i].nonzeros().end());
+      }
+      vector<DM> res = f(arg);
+      for (auto&& r : res) y.insert(y.end(), r.nonzeros().begin(), r.nonzeros().end());
+    }
+
+    string codegen_name = add_dependency(f);
+    add_include("math.h");
+    casadi_int nnz_in = f.nnz_in(), nnz_out = f.nnz_out();
+
+    *this << declare("double " + f.name() + "_precision_error(void)") << " {\n";
+    if (nnz_in>0) *this << array("static const double", "x", x.size(), initializer(x));
+    *this << array("static const double", "y", y.size(), initializer(y))
+          << array("casadi_int", "iw", f.sz_iw())
+          << array("casadi_real", "w", f->codegen_sz_w(*this) + nnz_in + nnz_out)
+          << "const casadi_real* arg[" << f.sz_arg() << "];\n"
+          << "casadi_real* res[" << f.sz_res() << "];\n"
+          << "casadi_int i, j;\n"
+          << "double e, err = 0;\n";
+
+    // Input and output buffers
+    casadi_int off = 0;
+    for (casadi_int i=0; i<f.n_in(); ++i) {
+      *this << "arg[" << i << "] = w+" << off << ";\n";
+      off += f.nnz_in(i);
+    }
+    for (casadi_int i=0; i<f.n_out(); ++i) {
+      *this << "res[" << i << "] = w+" << off << ";\n";
+      off += f.nnz_out(i);
+    }
+
+    // Evaluate samples and compare
+    *this << "for (j=0; j<" << samples.size() << "; ++j) {\n";
+    if (nnz_in>0) {
+      *this << "for (i=0; i<" << nnz_in << "; ++i) w[i] = (casadi_real)x[i+j*" << nnz_in << "];\n";
+    }
+    *this << "if (" << codegen_name << "(arg, res, iw, w+" << off << ", 0)) return -1;\n"
+          << "for (i=0; i<" << nnz_out << "; ++i) {\n"
+          << "e = fabs(w[" << nnz_in << "+i]-y[i+j*" << nnz_out << "])"
+          << "/(1+fabs(y[i+j*" << nnz_out << "]));\n"
+          << "if (e>err) err = e;\n"
+          << "}\n"
+          << "}\n"
+          << "return err;\n"
+          << "}\n\n";
+
+    // Flush buffers
+    flush(this->body);
+  }
+
   string CodeGenerator::dump() {
     stringstream s;
     dump(s);
@@ -413,17 +556,26 @@ namespace casadi {
     file_open(s, fullname);
 
     // Dump code to file
-    dump(s);
+    dump_preamble(s);
+    dump_body(s);
 
     // Mex entry point
     if (this->mex) generate_mex(s);
 
     // Main entry point
-    if (this->main) generate_main(s);
+    if (this->main || this->benchmark) generate_main(s);
 
     // Finalize file
     file_close(s);
 
+    // Parts of split function bodies, one file each so that they can be compiled in parallel
+    for (casadi_int k=0; k<parts_.size(); ++k) {
+      file_open(s, prefix + this->name + "_part" + str(k) + this->suffix);
+      dump_part_preamble(s);
+      dump_part(s, k);
+      file_close(s);
+    }
+
     // Generate header
     if (this->with_header) {
       // Create a header file
@@ -500,16 +652,26 @@ namespace casadi {
     // Create switch
     s << "  if (argc<2) {\n"
       << "    /* name error */\n";
-    for (casadi_int i=0; i<exposed_fname.size(); ++i) {
-      s << "  } else if (strcmp(argv[1], \"" << exposed_fname[i] << "\")==0) {\n"
-        << "    return main_" << exposed_fname[i] << "(argc-2, argv+2);\n";
+    if (this->main) {
+      for (casadi_int i=0; i<exposed_fname.size(); ++i) {
+        s << "  } else if (strcmp(argv[1], \"" << exposed_fname[i] << "\")==0) {\n"
+          << "    return main_" << exposed_fname[i] << "(argc-2, argv+2);\n";
+      }
+    }
+    if (this->benchmark) {
+      for (casadi_int i=0; i<exposed_fname.size(); ++i) {
+        s << "  } else if (argc>2 && strcmp(argv[1], \"benchmark\")==0 "
+          << "&& strcmp(argv[2], \"" << exposed_fname[i] << "\")==0) {\n"
+          << "    return benchmark_" << exposed_fname[i] << "(argc-3, argv+3);\n";
+      }
     }
     s << "  }\n";
 
     // Error
     s << "  fprintf(stderr, \"First input should be a command string. Possible values:";
     for (casadi_int i=0; i<exposed_fname.size(); ++i) {
-      s << " '" << exposed_fname[i] << "'";
+      if (this->main) s << " '" << exposed_fname[i] << "'";
+      if (this->benchmark) s << " 'benchmark " << exposed_fname[i] << "'";
     }
     s << "\\n";
     s << "Note: you may use function.generate_input to create a command string.";
@@ -549,18 +711,19 @@ namespace casadi {
   }
 
   void CodeGenerator::dump(std::ostream& s) {
+    dump_preamble(s);
+    dump_body(s);
+
+    // Parts of split function bodies
+    for (casadi_int k=0; k<parts_.size(); ++k) dump_part(s, k);
+  }
+
+  void CodeGenerator::dump_preamble(std::ostream& s) {
     // Consistency check
     casadi_assert_dev(current_indent_ == 0);
 
     // Prefix internal symbols to avoid symbol collisions
-    s << "/* How to prefix internal symbols */\n"
-      << "#ifdef CASADI_CODEGEN_PREFIX\n"
-      << "  #define CASADI_NAMESPACE_CONCAT(NS, ID) _CASADI_NAMESPACE_CONCAT(NS, ID)\n"
-      << "  #define _CASADI_NAMESPACE_CONCAT(NS, ID) NS ## ID\n"
-      << "  #define CASADI_PREFIX(ID) CASADI_NAMESPACE_CONCAT(CODEGEN_PREFIX, ID)\n"
-      << "#else\n"
-      << "  #define CASADI_PREFIX(ID) " << this->prefix << "_ ## ID\n"
-      << "#endif\n\n";
+    generate_prefix(s);
 
     s << this->includes.str();
     s << endl;
@@ -578,6 +741,30 @@ namespace casadi {
       s << "#endif\n\n";
     }
 
+    if (needs_mem_ && this->thread_safe) {
+      // Atomic operations, C11 or C++11
+      s << "#ifdef __cplusplus\n"
+        << "extern \"C++\" {\n"
+        << "#include <atomic>\n"
+        << "}\n"
+        << "typedef std::atomic<int> casadi_atomic_int;\n"
+        << "#define casadi_atomic_load(p) std::atomic_load(p)\n"
+        << "#define casadi_atomic_store(p, v) std::atomic_store(p, v)\n"
+        << "#define casadi_atomic_fetch_add(p, v) std::atomic_fetch_add(p, v)\n"
+        << "#define casadi_atomic_cas(p, e, v) std::atomic_compare_exchange_strong(p, e, v)\n"
+        << "#else\n"
+        << "#ifdef __STDC_NO_ATOMICS__\n"
+        << "#error \"Option 'thread_safe' requires C11 atomics\"\n"
+        << "#endif\n"
+        << "#include <stdatomic.h>\n"
+        << "typedef atomic_int casadi_atomic_int;\n"
+        << "#define casadi_atomic_load(p) atomic_load(p)\n"
+        << "#define casadi_atomic_store(p, v) atomic_store(p, v)\n"
+        << "#define casadi_atomic_fetch_add(p, v) atomic_fetch_add(p, v)\n"
+        << "#define casadi_atomic_cas(p, e, v) atomic_compare_exchange_strong(p, e, v)\n"
+        << "#endif\n\n";
+    }
+
     // casadi/mem after numeric types to define derived types
     // Memory struct entry point
     if (this->with_mem) {
@@ -585,13 +772,7 @@ namespace casadi {
     }
 
     // Macros
-    if (!added_shorthands_.empty()) {
-      s << "/* Add prefix to internal symbols */\n";
-      for (auto&& i : added_shorthands_) {
-        s << "#define " << "casadi_" << i <<  " CASADI_PREFIX(" << i <<  ")\n";
-      }
-      s << endl;
-    }
+    generate_shorthands(s);
 
     if (this->with_export) generate_export_symbol(s);
 
@@ -605,7 +786,9 @@ namespace casadi {
 
     // Codegen auxiliary functions
     s << this->auxiliaries.str();
+  }
 
+  void CodeGenerator::dump_body(std::ostream& s) {
     // Print integer constants
     if (!integer_constants_.empty()) {
       for (casadi_int i=0; i<integer_constants_.size(); ++i) {
@@ -649,6 +832,14 @@ namespace casadi {
       s << endl << endl;
     }
 
+    // Parts of split function bodies, defined in separate files
+    if (!parts_.empty()) {
+      for (auto&& p : parts_) {
+        s << "void " << p.first << "(const casadi_real** arg, casadi_real** res, casadi_real* w);\n";
+      }
+      s << endl;
+    }
+
     // Codegen body
     s << this->body.str();
 
@@ -656,6 +847,71 @@ namespace casadi {
     s << endl;
   }
 
+  void CodeGenerator::generate_prefix(std::ostream& s) const {
+    s << "/* How to prefix internal symbols */\n"
+      << "#ifdef CASADI_CODEGEN_PREFIX\n"
+      << "  #define CASADI_NAMESPACE_CONCAT(NS, ID) _CASADI_NAMESPACE_CONCAT(NS, ID)\n"
+      << "  #define _CASADI_NAMESPACE_CONCAT(NS, ID) NS ## ID\n"
+      << "  #define CASADI_PREFIX(ID) CASADI_NAMESPACE_CONCAT(CODEGEN_PREFIX, ID)\n"
+      << "#else\n"
+      << "  #define CASADI_PREFIX(ID) " << this->prefix << "_ ## ID\n"
+      << "#endif\n\n";
+  }
+
+  void CodeGenerator::generate_shorthands(std::ostream& s) const {
+    if (!added_shorthands_.empty()) {
+      s << "/* Add prefix to internal symbols */\n";
+      for (auto&& i : added_shorthands_) {
+        s << "#define " << "casadi_" << i <<  " CASADI_PREFIX(" << i <<  ")\n";
+      }
+      s << endl;
+    }
+  }
+
+  void CodeGenerator::dump_part_preamble(std::ostream& s) const {
+    // Same symbol names as in the main file
+    generate_prefix(s);
+    s << this->includes.str();
+    s << endl;
+    generate_casadi_real(s);
+    generate_casadi_int(s);
+    generate_shorthands(s);
+
+    // Auxiliaries that may appear in a split SX function body, defined in the main file
+    if (added_auxiliaries_.count(AUX_INF)) {
+      s << "#ifndef casadi_inf\n"
+        << "  #define casadi_inf " << this->infinity << "\n"
+        << "#endif\n\n";
+    }
+    if (added_auxiliaries_.count(AUX_NAN)) {
+      s << "#ifndef casadi_nan\n"
+        << "  #define casadi_nan " << this->nan << "\n"
+        << "#endif\n\n";
+    }
+    if (added_auxiliaries_.count(AUX_SQ)) s << "casadi_real casadi_sq(casadi_real x);\n";
+    if (added_auxiliaries_.count(AUX_SIGN)) s << "casadi_real casadi_sign(casadi_real x);\n";
+    if (added_auxiliaries_.count(AUX_FMIN)) {
+      s << "casadi_real casadi_fmin(casadi_real x, casadi_real y);\n";
+    }
+    if (added_auxiliaries_.count(AUX_FMAX)) {
+      s << "casadi_real casadi_fmax(casadi_real x, casadi_real y);\n";
+    }
+    s << endl;
+  }
+
+  void CodeGenerator::dump_part(std::ostream& s, casadi_int k) const {
+    s << "void " << parts_.at(k).first
+      << "(const casadi_real** arg, casadi_real** res, casadi_real* w) {\n"
+      << parts_.at(k).second
+      << "}\n\n";
+  }
+
+  string CodeGenerator::add_part(const string& name, const string& body) {
+    string fname = shorthand(name, false);
+    parts_.push_back(make_pair(fname, body));
+    return fname;
+  }
+
   string CodeGenerator::work(casadi_int n, casadi_int sz) const {
     if (n<0 || sz==0) {
       return "0";
@@ -745,6 +1001,25 @@ namespace casadi {
     if (!use_ifdef.empty()) this->includes << "#endif\n";
   }
 
+  bool CodeGenerator::use_cblas(casadi_int sz) {
+    // Only double precision kernels are mapped to BLAS
+    if (this->blas_threshold==0 || sz<this->blas_threshold) return false;
+    if (this->casadi_real_type!="double") return false;
+    add_include("cblas.h", false, "CASADI_WITH_CBLAS");
+    return true;
+  }
+
+  bool CodeGenerator::use_lapacke(casadi_int sz) {
+    if (!has_lapacke(sz)) return false;
+    add_include("lapacke.h", false, "CASADI_WITH_LAPACKE");
+    return true;
+  }
+
+  bool CodeGenerator::has_lapacke(casadi_int sz) const {
+    if (this->blas_threshold==0 || sz<this->blas_threshold) return false;
+    return this->casadi_real_solve_type=="double";
+  }
+
   string CodeGenerator::
   operator()(const Function& f, const string& arg,
              const string& res, const string& iw,
@@ -1025,10 +1300,10 @@ namespace casadi {
       this->auxiliaries << sanitize_source(casadi_finite_diff_str, inst);
       break;
     case AUX_QR:
-      add_auxiliary(AUX_IF_ELSE);
-      add_auxiliary(AUX_SCAL);
-      add_auxiliary(AUX_DOT);
-      add_auxiliary(AUX_CLEAR);
+      add_auxiliary(AUX_IF_ELSE, inst);
+      add_auxiliary(AUX_SCAL, inst);
+      add_auxiliary(AUX_DOT, inst);
+      add_auxiliary(AUX_CLEAR, inst);
       this->auxiliaries << sanitize_source(casadi_qr_str, inst);
       break;
     case AUX_LSQR:
@@ -1146,10 +1421,15 @@ namespace casadi {
                         << "{ return x<0 ? -1 : x>0 ? 1 : x;}\n\n";
       break;
     case AUX_IF_ELSE:
-      shorthand("if_else");
-      this->auxiliaries << "casadi_real casadi_if_else"
-                        << "(casadi_real c, casadi_real x, casadi_real y) "
-                        << "{ return c!=0 ? x : y;}\n\n";
+      {
+        // Instantiated with a suffix for a type other than casadi_real
+        string t = inst.at(0);
+        string suffix = t=="casadi_real" ? "" : "_" + t;
+        shorthand("if_else" + suffix);
+        this->auxiliaries << t << " casadi_if_else" << suffix
+                          << "(" << t << " c, " << t << " x, " << t << " y) "
+                          << "{ return c!=0 ? x : y;}\n\n";
+      }
       break;
     case AUX_PRINTF:
       this->auxiliaries << "#ifndef CASADI_PRINTF\n";
@@ -1228,6 +1508,124 @@ namespace casadi {
                         << "  #define casadi_nan " << this->nan << "\n"
                         << "#endif\n\n";
       break;
+    case AUX_BENCHMARK:
+      add_include("stdio.h");
+      add_include("stdlib.h");
+      add_include("time.h");
+      add_include("windows.h", false, "_WIN32");
+      add_include("unistd.h", false, "CASADI_WITH_PERF");
+      add_include("sys/ioctl.h", false, "CASADI_WITH_PERF");
+      add_include("sys/syscall.h", false, "CASADI_WITH_PERF");
+      add_include("linux/perf_event.h", false, "CASADI_WITH_PERF");
+      shorthand("bench_clock");
+      shorthand("bench_cmp");
+      shorthand("bench_perf_open");
+      shorthand("bench");
+      // Monotonic wall clock in seconds
+      this->auxiliaries << "double casadi_bench_clock(void) {\n"
+                        << "#ifdef _WIN32\n"
+                        << "  LARGE_INTEGER t, f;\n"
+                        << "  QueryPerformanceCounter(&t);\n"
+                        << "  QueryPerformanceFrequency(&f);\n"
+                        << "  return (double)t.QuadPart/(double)f.QuadPart;\n"
+                        << "#else\n"
+                        << "  struct timespec t;\n"
+                        << "  clock_gettime(CLOCK_MONOTONIC, &t);\n"
+                        << "  return (double)t.tv_sec + 1e-9*(double)t.tv_nsec;\n"
+                        << "#endif\n"
+                        << "}\n\n";
+      this->auxiliaries << "int casadi_bench_cmp(const void* a, const void* b) {\n"
+                        << "  double d = *(const double*)a - *(const double*)b;\n"
+                        << "  return d<0 ? -1 : d>0 ? 1 : 0;\n"
+                        << "}\n\n";
+      // Hardware counters for the calling thread, user space only
+      this->auxiliaries << "#ifdef CASADI_WITH_PERF\n"
+                        << "int casadi_bench_perf_open(unsigned long long config) {\n"
+                        << "  struct perf_event_attr pe;\n"
+                        << "  memset(&pe, 0, sizeof(pe));\n"
+                        << "  pe.type = PERF_TYPE_HARDWARE;\n"
+                        << "  pe.size = sizeof(pe);\n"
+                        << "  pe.config = config;\n"
+                        << "  pe.disabled = 1;\n"
+                        << "  pe.exclude_kernel = 1;\n"
+                        << "  pe.exclude_hv = 1;\n"
+                        << "  return (int)syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);\n"
+                        << "}\n"
+                        << "#endif\n\n";
+      // Warm up, time n evaluations individually, report percentiles and throughput
+      this->auxiliaries
+        << "int casadi_bench(int (*f)(const casadi_real**, casadi_real**, casadi_int*, "
+        << "casadi_real*, int),\n"
+        << "    const casadi_real** arg, casadi_real** res, casadi_int* iw, casadi_real* w,\n"
+        << "    long n, long n_warmup) {\n"
+        << "  long k;\n"
+        << "  double *t, t0, total, mean;\n"
+        << "#ifdef CASADI_WITH_PERF\n"
+        << "  static const unsigned long long cfg[3] = {PERF_COUNT_HW_CPU_CYCLES,\n"
+        << "    PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};\n"
+        << "  static const char* cfg_name[3] = {\"cycles\", \"instructions\", \"cache misses\"};\n"
+        << "  int i, fd[3];\n"
+        << "  long long cnt[3];\n"
+        << "#endif\n"
+        << "  if (n<1) return 1;\n"
+        << "  t = (double*)malloc(n*sizeof(double));\n"
+        << "  if (!t) return 1;\n"
+        << "  for (k=0; k<n_warmup; ++k) {\n"
+        << "    if (f(arg, res, iw, w, 0)) {\n"
+        << "      free(t);\n"
+        << "      return 1;\n"
+        << "    }\n"
+        << "  }\n"
+        << "#ifdef CASADI_WITH_PERF\n"
+        << "  for (i=0; i<3; ++i) {\n"
+        << "    fd[i] = casadi_bench_perf_open(cfg[i]);\n"
+        << "    if (fd[i]>=0) {\n"
+        << "      ioctl(fd[i], PERF_EVENT_IOC_RESET, 0);\n"
+        << "      ioctl(fd[i], PERF_EVENT_IOC_ENABLE, 0);\n"
+        << "    }\n"
+        << "  }\n"
+        << "#endif\n"
+        << "  total = casadi_bench_clock();\n"
+        << "  for (k=0; k<n; ++k) {\n"
+        << "    t0 = casadi_bench_clock();\n"
+        << "    if (f(arg, res, iw, w, 0)) {\n"
+        << "      free(t);\n"
+        << "      return 1;\n"
+        << "    }\n"
+        << "    t[k] = casadi_bench_clock() - t0;\n"
+        << "  }\n"
+        << "  total = casadi_bench_clock() - total;\n"
+        << "#ifdef CASADI_WITH_PERF\n"
+        << "  for (i=0; i<3; ++i) {\n"
+        << "    cnt[i] = -1;\n"
+        << "    if (fd[i]<0) continue;\n"
+        << "    ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);\n"
+        << "    if (read(fd[i], cnt+i, sizeof(cnt[i]))!=sizeof(cnt[i])) cnt[i] = -1;\n"
+        << "    close(fd[i]);\n"
+        << "  }\n"
+        << "#endif\n"
+        << "  mean = 0;\n"
+        << "  for (k=0; k<n; ++k) mean += t[k];\n"
+        << "  mean /= (double)n;\n"
+        << "  qsort(t, n, sizeof(double), casadi_bench_cmp);\n"
+        << "  printf(\"evaluations: %ld (warmup %ld)\\n\", n, n_warmup);\n"
+        << "  printf(\"latency [us]: min %g, p50 %g, p90 %g, p99 %g, max %g, mean %g\\n\",\n"
+        << "    1e6*t[0], 1e6*t[(n-1)/2], 1e6*t[(long)(0.9*(double)(n-1))],\n"
+        << "    1e6*t[(long)(0.99*(double)(n-1))], 1e6*t[n-1], 1e6*mean);\n"
+        << "  printf(\"throughput: %g evaluations/s\\n\", (double)n/total);\n"
+        << "#ifdef CASADI_WITH_PERF\n"
+        << "  for (i=0; i<3; ++i) {\n"
+        << "    if (cnt[i]<0) {\n"
+        << "      printf(\"%s: not available\\n\", cfg_name[i]);\n"
+        << "    } else {\n"
+        << "      printf(\"%s: %g per evaluation\\n\", cfg_name[i], (double)cnt[i]/(double)n);\n"
+        << "    }\n"
+        << "  }\n"
+        << "#endif\n"
+        << "  free(t);\n"
+        << "  return 0;\n"
+        << "}\n\n";
+      break;
     case AUX_REAL_MIN:
       this->auxiliaries << "#ifndef casadi_real_min\n"
                         << "  #define casadi_real_min " << this->real_min << "\n"
@@ -1654,6 +2052,9 @@ namespace casadi {
       rep.push_back(make_pair("T" + str(i+1), inst[i]));
     }
 
+    // Symbols defined in the source, renamed if suffix is non-empty
+    set<string> syms;
+
     // Return object
     stringstream ret;
     // Process C++ source
@@ -1678,9 +2079,7 @@ namespace casadi {
         n2 = line.find("\"", n1+1);
         string sym = line.substr(n1+1, n2-n1-1);
         if (add_shorthand) shorthand(sym + suffix);
-        if (!suffix.empty()) {
-          rep.push_back(make_pair(sym, sym + suffix));
-        }
+        if (!suffix.empty()) syms.insert(sym);
         continue;
       }
 
@@ -1725,6 +2124,26 @@ namespace casadi {
         }
       }
 
+      // Instantiate symbols: both those defined here and calls to auxiliaries
+      // that are instantiated with the same template arguments
+      if (!suffix.empty()) {
+        string::size_type n = 0;
+        while ((n = line.find("casadi_", n)) != string::npos) {
+          string::size_type e = n + 7;
+          while (e<line.size() && (isalnum(line[e]) || line[e]=='_')) e++;
+          if (n>0 && (isalnum(line[n-1]) || line[n-1]=='_')) {
+            n = e;
+            continue;
+          }
+          string sym = line.substr(n + 7, e - n - 7);
+          if (syms.count(sym) || added_shorthands_.count(sym + suffix)) {
+            line.insert(e, suffix);
+            e += suffix.size();
+          }
+          n = e;
+        }
+      }
+
       // Append to return
       ret << line << "\n";
     }
@@ -1766,12 +2185,19 @@ namespace casadi {
       << "}\n\n";
   }
 
+  string CodeGenerator::solve_real() const {
+    if (this->casadi_real_solve_type==this->casadi_real_type) return "casadi_real";
+    return this->casadi_real_solve_type;
+  }
+
   string CodeGenerator::
   qr(const string& sp, const string& A, const string& w,
      const string& sp_v, const string& v, const string& sp_r,
      const string& r, const string& beta, const string& prinv, const string& pc) {
-    add_auxiliary(CodeGenerator::AUX_QR);
-    return "casadi_qr(" + sp + ", " + A + ", " + w + ", "
+    string t = solve_real();
+    add_auxiliary(CodeGenerator::AUX_QR, {t});
+    string suffix = t=="casadi_real" ? "" : "_" + t;
+    return "casadi_qr" + suffix + "(" + sp + ", " + A + ", " + w + ", "
            + sp_v + ", " + v + ", " + sp_r + ", " + r + ", "
            + beta + ", " + prinv + ", " + pc + ");";
   }
@@ -1782,8 +2208,10 @@ namespace casadi {
            const string& sp_r, const string& r,
            const string& beta, const string& prinv,
            const string& pc, const string& w) {
-    add_auxiliary(CodeGenerator::AUX_QR);
-    return "casadi_qr_solve(" + x + ", " + str(nrhs) + ", " + (tr ? "1" : "0") + ", "
+    string t = solve_real();
+    add_auxiliary(CodeGenerator::AUX_QR, {t});
+    string suffix = t=="casadi_real" ? "" : "_" + t;
+    return "casadi_qr_solve" + suffix + "(" + x + ", " + str(nrhs) + ", " + (tr ? "1" : "0") + ", "
            + sp_v + ", " + v + ", " + sp_r + ", " + r + ", "
            + beta + ", " + prinv + ", " + pc + ", " + w + ");";
   }
@@ -1800,8 +2228,10 @@ namespace casadi {
   ldl(const std::string& sp_a, const std::string& a,
       const std::string& sp_lt, const std::string& lt, const std::string& d,
       const std::string& p, const std::string& w) {
-    add_auxiliary(CodeGenerator::AUX_LDL);
-    return "casadi_ldl(" + sp_a + ", " + a + ", " + sp_lt + ", " + lt + ", "
+    string t = solve_real();
+    add_auxiliary(CodeGenerator::AUX_LDL, {t});
+    string suffix = t=="casadi_real" ? "" : "_" + t;
+    return "casadi_ldl" + suffix + "(" + sp_a + ", " + a + ", " + sp_lt + ", " + lt + ", "
            + d + ", " + p + ", " + w + ");";
   }
 
@@ -1809,8 +2239,10 @@ namespace casadi {
   ldl_solve(const std::string& x, casadi_int nrhs,
     const std::string& sp_lt, const std::string& lt, const std::string& d,
     const std::string& p, const std::string& w) {
-    add_auxiliary(CodeGenerator::AUX_LDL);
-    return "casadi_ldl_solve(" + x + ", " + str(nrhs) + ", " + sp_lt + ", "
+    string t = solve_real();
+    add_auxiliary(CodeGenerator::AUX_LDL, {t});
+    string suffix = t=="casadi_real" ? "" : "_" + t;
+    return "casadi_ldl_solve" + suffix + "(" + x + ", " + str(nrhs) + ", " + sp_lt + ", "
            + lt + ", " + d + ", " + p + ", " + w + ");";
   }
 
@@ -46,6 +46,15 @@ namespace casadi {
     /// Add a function (name generated)
     void add(const Function& f, bool with_jac_sparsity=false);
 
+    /** \brief Add a precision check for a function
+     * Evaluates f in double precision for each sample of inputs and generates
+     * double <f>_precision_error(void), which evaluates the generated code on the same
+     * samples and returns the largest error |y-y_ref|/(1+|y_ref|), or -1 if evaluation failed.
+     * Use to assess a reduced or mixed precision build (options "casadi_real",
+     * "casadi_real_solve").
+     */
+    void add_precision_check(const Function& f, const std::vector<std::vector<DM> >& samples);
+
 #ifndef SWIG
     /// Generate the code to a stream
     void dump(std::ostream& s);
@@ -57,10 +66,25 @@ namespace casadi {
     /** \brief Generate file(s)
       The "prefix" argument will be prepended to the generated files and may
       be a directory or a file prefix.
+      Parts split off by the "split_size" option are written to separate files
+      <name>_part<k> that need to be compiled and linked along with the main file.
       returns the filename
     */
     std::string generate(const std::string& prefix="");
 
+    /** \brief Emit a CBLAS call for a dense kernel with sz multiply-adds?
+     * If so, cblas.h is included, guarded by CASADI_WITH_CBLAS
+     */
+    bool use_cblas(casadi_int sz);
+
+    /** \brief Emit a LAPACKE call for a dense kernel with sz multiply-adds?
+     * If so, lapacke.h is included, guarded by CASADI_WITH_LAPACKE
+     */
+    bool use_lapacke(casadi_int sz);
+
+    /** \brief Would use_lapacke return true? Without including lapacke.h */
+    bool has_lapacke(casadi_int sz) const;
+
     /// Add an include file optionally using a relative path "..." instead of an absolute path <...>
     void add_include(const std::string& new_include, bool relative_path=false,
                     const std::string& use_ifdef=std::string());
@@ -72,6 +96,11 @@ namespace casadi {
     /// Add an external function declaration
     void add_external(const std::string& new_external);
 
+    /** \brief Add a part of a split function body, returns the name to call
+        The part is a function taking (arg, res, w) and is placed in a separate file by generate
+    */
+    std::string add_part(const std::string& name, const std::string& body);
+
     /// Get a shorthand
     std::string shorthand(const std::string& name) const;
 
@@ -224,6 +253,9 @@ namespace casadi {
     std::string trans(const std::string& x, const Sparsity& sp_x,
       const std::string& y, const Sparsity& sp_y, const std::string& iw);
 
+    /** \brief Floating point type of linear solver kernels (QR, LDL) */
+    std::string solve_real() const;
+
     /** \brief QR factorization */
     std::string qr(const std::string& sp, const std::string& A,
                    const std::string& w, const std::string& sp_v,
@@ -379,7 +411,8 @@ namespace casadi {
       AUX_BOUNDS_CONSISTENCY,
       AUX_LSQR,
       AUX_FILE_SLURP,
-      AUX_CACHE
+      AUX_CACHE,
+      AUX_BENCHMARK
     };
 
     /** \brief Add a built-in auxiliary function */
@@ -500,6 +533,24 @@ namespace casadi {
     // Generate import symbol macros
     void generate_import_symbol(std::ostream &s) const;
 
+    // Generate macros for prefixing internal symbols
+    void generate_prefix(std::ostream &s) const;
+
+    // Generate prefixed shorthands
+    void generate_shorthands(std::ostream &s) const;
+
+    // Generate everything up to and including the auxiliary functions
+    void dump_preamble(std::ostream& s);
+
+    // Generate declarations needed by a part of a split function body
+    void dump_part_preamble(std::ostream& s) const;
+
+    // Generate constants, declarations and function bodies
+    void dump_body(std::ostream& s);
+
+    // Generate a part of a split function body
+    void dump_part(std::ostream& s, casadi_int k) const;
+
     //  private:
   public:
     /// \cond INTERNAL
@@ -510,12 +561,18 @@ namespace casadi {
     // Real-type used for the codegen
     std::string casadi_real_type;
 
+    // Real-type used for linear solves, if different from casadi_real (mixed precision)
+    std::string casadi_real_solve_type;
+
     // Int-type used for the codegen
     std::string casadi_int_type;
 
     // Should we create a memory entry point?
     bool with_mem;
 
+    // Generate batch entry points where supported?
+    bool with_batch;
+
     // Generate header file?
     bool with_header;
 
@@ -534,12 +591,27 @@ namespace casadi {
     // Should we generate a main (allowing evaluation from command line)
     bool main;
 
+    // Should we generate a benchmark driver (timing evaluations from command line)
+    bool benchmark;
+
     // Should we include mayth library?
     bool include_math;
 
     // Do we want to be lean on stack usage?
     bool avoid_stack_;
 
+    // Lock-free, thread-safe checkout/release of memory objects?
+    bool thread_safe;
+
+    // Maximum number of operations in a function body before it is split into parts (0: never)
+    casadi_int split_size;
+
+    // Minimum number of operations in repeated blocks that are emitted as a loop (0: never)
+    casadi_int reroll;
+
+    // Minimum number of multiply-adds for dense kernels to call CBLAS/LAPACKE (0: never)
+    casadi_int blas_threshold;
+
     std::string infinity, nan, real_min;
 
     /** \brief Codegen scalar
@@ -605,6 +677,9 @@ namespace casadi {
     // Does any function need thread-local memory?
     bool needs_mem_;
 
+    // Parts of split function bodies: name and body
+    std::vector<std::pair<std::string, std::string> > parts_;
+
     // Hash a vector
     static size_t hash(const std::vector<double>& v);
     static size_t hash(const std::vector<casadi_int>& v);
@@ -53,9 +53,11 @@ namespace casadi {
 
     // Creator (all values are the same integer)
     static ConstantMX* create(const Sparsity& sp, casadi_int val);
+#ifndef CASADI_INT32
     static ConstantMX* create(const Sparsity& sp, int val) {
       return create(sp, static_cast<casadi_int>(val));
     }
+#endif // CASADI_INT32
 
     // Creator (all values are the same floating point value)
     static ConstantMX* create(const Sparsity& sp, double val);
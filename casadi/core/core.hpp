@@ -44,6 +44,7 @@
 #include "mx.hpp"
 
 // Functions
+#include "function_future.hpp"
 #include "code_generator.hpp"
 #include "importer.hpp"
 #include "callback.hpp"
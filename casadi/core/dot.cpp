@@ -96,9 +96,17 @@ namespace casadi {
   void Dot::generate(CodeGenerator& g,
                       const std::vector<casadi_int>& arg,
                       const std::vector<casadi_int>& res) const {
-    g << g.workel(res[0]) << " = "
-      << g.dot(dep().nnz(), g.work(arg[0], dep(0).nnz()), g.work(arg[1], dep(1).nnz()))
-      << ";\n";
+    std::string x = g.work(arg[0], dep(0).nnz()), y = g.work(arg[1], dep(1).nnz());
+    if (g.use_cblas(dep().nnz())) {
+      g << "#ifdef CASADI_WITH_CBLAS\n";
+      g << g.workel(res[0]) << " = cblas_ddot(" << dep().nnz() << ", " << x << ", 1, "
+        << y << ", 1);\n";
+      g << "#else\n";
+      g << g.workel(res[0]) << " = " << g.dot(dep().nnz(), x, y) << ";\n";
+      g << "#endif\n";
+    } else {
+      g << g.workel(res[0]) << " = " << g.dot(dep().nnz(), x, y) << ";\n";
+    }
   }
 
 } // namespace casadi
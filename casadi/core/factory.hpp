@@ -248,6 +248,10 @@ namespace casadi {
   void Factory<MatType>::calculate(const Dict& opts) {
     using namespace std;
 
+    // The Hessian construction strategy only applies to Hessian blocks
+    Dict d_opts = opts;
+    d_opts.erase("hessian_method");
+
     // Dual variables
     for (auto&& e : out_) {
       Sparsity sp = is_diff_out_[e.first] ? e.second.sparsity() : Sparsity(e.second.size());
@@ -272,7 +276,7 @@ namespace casadi {
         res.push_back(out_[s]);
       }
       // Calculate directional derivatives
-      Dict local_opts = opts;
+      Dict local_opts = d_opts;
       local_opts["always_inline"] = true;
       try {
         sens = forward(res, arg, seed, local_opts);
@@ -339,7 +343,7 @@ namespace casadi {
       const MatType& arg = in_.at(b.arg);
       try {
         if (is_diff_out_.at(b.ex) && is_diff_in_.at(b.arg)) {
-          out_["jac:" + b.ex + ":" + b.arg] = MatType::jacobian(ex, arg, opts);
+          out_["jac:" + b.ex + ":" + b.arg] = MatType::jacobian(ex, arg, d_opts);
           is_diff_out_["jac:" + b.ex + ":" + b.arg] = true;
         } else {
           out_["jac:" + b.ex + ":" + b.arg] = MatType(ex.numel(), arg.numel());
@@ -356,7 +360,7 @@ namespace casadi {
       const MatType& arg = in_.at(b.arg);
       try {
         if (is_diff_out_.at(b.ex) && is_diff_in_.at(b.arg)) {
-          out_["grad:" + b.ex + ":" + b.arg] = project(gradient(ex, arg, opts), arg.sparsity());
+          out_["grad:" + b.ex + ":" + b.arg] = project(gradient(ex, arg, d_opts), arg.sparsity());
           is_diff_out_["grad:" + b.ex + ":" + b.arg] = true;
         } else {
           casadi_assert(ex.is_scalar(), "Can only take gradient of scalar expression.");
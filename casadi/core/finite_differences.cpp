@@ -67,6 +67,11 @@ namespace casadi {
         {OT_INT,
         "Number of iterations to improve on the step-size "
         "[default: 1 if error estimate available, otherwise 0]"}},
+      {"parallelization",
+        {OT_STRING,
+        "Evaluate the perturbed inputs of all directions in a single mapped call "
+        "with this parallelization: serial|openmp|thread|process. Each parallel "
+        "worker uses its own memory object. [default: one call per perturbation]"}},
      }
   };
 
@@ -102,6 +107,8 @@ namespace casadi {
         u_aim_ = op.second;
       } else if (op.first=="h_iter") {
         h_iter_ = op.second;
+      } else if (op.first=="parallelization") {
+        parallelization_ = op.second.to_string();
       }
     }
 
@@ -128,6 +135,13 @@ namespace casadi {
 
     // Allocate sufficient temporary memory for function evaluation
     alloc(derivative_of_);
+
+    // Batched evaluation of all perturbations
+    if (!parallelization_.empty()) {
+      fmap_ = derivative_of_.map(n_ * n_pert(), parallelization_);
+      alloc_w(n_ + n_ * n_pert() * (n_z_ + n_y_), true); // h, z, y
+      alloc(fmap_);
+    }
   }
 
   Sparsity FiniteDiff::get_sparsity_in(casadi_int i) {
@@ -200,6 +214,9 @@ namespace casadi {
 
   int FiniteDiff::eval(const double** arg, double** res,
       casadi_int* iw, double* w, void* mem) const {
+    // Evaluate all perturbations at once?
+    if (!fmap_.is_null()) return eval_batch(arg, res, iw, w);
+
     // Shorthands
     casadi_int n_in = derivative_of_.n_in(), n_out = derivative_of_.n_out();
     casadi_int n_pert = this->n_pert();
@@ -298,6 +315,119 @@ namespace casadi {
     return 0;
   }
 
+  int FiniteDiff::eval_batch(const double** arg, double** res,
+      casadi_int* iw, double* w) const {
+    // Shorthands
+    casadi_int n_in = derivative_of_.n_in(), n_out = derivative_of_.n_out();
+    casadi_int n_pert = this->n_pert();
+
+    // Non-differentiated input
+    const double** x0 = arg;
+    arg += n_in;
+
+    // Non-differentiated output
+    double* y0 = w;
+    for (casadi_int j=0; j<n_out; ++j) {
+      const casadi_int nnz = derivative_of_.nnz_out(j);
+      casadi_copy(*arg++, nnz, w);
+      w += nnz;
+    }
+
+    // Forward seeds
+    const double** seed = arg;
+    arg += n_in;
+
+    // Forward sensitivities
+    double** sens = res;
+    res += n_out;
+
+    // Finite difference approximation
+    double* J = w;
+    w += n_y_;
+
+    // Perturbed function values of one direction
+    double** yk = res;
+    res += n_pert;
+    for (casadi_int k=0; k<n_pert; ++k) {
+      yk[k] = w, w += n_y_;
+    }
+    w += n_y_ + n_z_;  // unused (y, z)
+
+    // Step size for each direction
+    double* h = w;
+    w += n_;
+    casadi_fill(h, n_, h_);
+
+    // Inputs of all evaluations, evaluation k of direction i has index i*n_pert + k
+    for (casadi_int j=0; j<n_in; ++j) {
+      arg[j] = w;
+      w += n_ * n_pert * derivative_of_.nnz_in(j);
+    }
+
+    // Outputs of all evaluations
+    for (casadi_int j=0; j<n_out; ++j) {
+      res[j] = w;
+      w += n_ * n_pert * derivative_of_.nnz_out(j);
+    }
+
+    // Perform finite difference algorithm with different step sizes
+    for (casadi_int iter=0; iter<1+h_iter_; ++iter) {
+      // Perturb inputs
+      for (casadi_int j=0; j<n_in; ++j) {
+        casadi_int nnz = derivative_of_.nnz_in(j);
+        double* z = const_cast<double*>(arg[j]);
+        for (casadi_int i=0; i<n_; ++i) {
+          for (casadi_int k=0; k<n_pert; ++k) {
+            casadi_copy(x0[j], nnz, z);
+            if (seed[j]) casadi_axpy(nnz, pert(k, h[i]), seed[j] + i*nnz, z);
+            z += nnz;
+          }
+        }
+      }
+
+      // Evaluate all perturbations
+      if (fmap_(arg, res, iw, w)) return 1;
+
+      // For all sensitivity directions
+      for (casadi_int i=0; i<n_; ++i) {
+        // Collect perturbed function values
+        for (casadi_int k=0; k<n_pert; ++k) {
+          casadi_int off = 0;
+          for (casadi_int j=0; j<n_out; ++j) {
+            casadi_int nnz = derivative_of_.nnz_out(j);
+            casadi_copy(res[j] + (i*n_pert + k)*nnz, nnz, yk[k] + off);
+            off += nnz;
+          }
+        }
+
+        // Finite difference calculation with error estimate
+        double u = calc_fd(yk, y0, J, h[i]);
+
+        if (iter==h_iter_) {
+          // Gather sensitivities
+          casadi_int off = 0;
+          for (casadi_int j=0; j<n_out; ++j) {
+            casadi_int nnz = derivative_of_.nnz_out(j);
+            if (sens[j]) casadi_copy(J + off, nnz, sens[j] + i*nnz);
+            off += nnz;
+          }
+        } else {
+          // Update step size
+          if (u < 0) {
+            // Perturbation failed, try a smaller step size
+            h[i] /= u_aim_;
+          } else {
+            // Update h to get u near the target ratio
+            h[i] *= sqrt(u_aim_ / fmax(1., u));
+          }
+          // Make sure h stays in the range [h_min_,h_max_]
+          h[i] = fmin(fmax(h[i], h_min_), h_max_);
+        }
+      }
+    }
+    return 0;
+  }
+
   double ForwardDiff::calc_fd(double** yk, double* y0, double* J, double h) const {
     return casadi_forward_diff(yk, y0, J, h, n_y_, &m_);
   }
@@ -89,6 +89,9 @@ namespace casadi {
     void codegen_body(CodeGenerator& g) const override;
 
   protected:
+    // Evaluate all perturbations of a step size iteration in a single mapped call
+    int eval_batch(const double** arg, double** res, casadi_int* iw, double* w) const;
+
     // Number of function evaluations needed
     virtual casadi_int n_pert() const = 0;
 
@@ -130,6 +133,12 @@ namespace casadi {
 
     // Memory object
     casadi_finite_diff_mem<double> m_;
+
+    // Parallelization of the batched evaluation, empty if not batched
+    std::string parallelization_;
+
+    // Function mapped over all directions and perturbations
+    Function fmap_;
   };
 
   /** Calculate derivative using forward differences
@@ -576,6 +576,14 @@ namespace casadi {
       *this, n, reduce_in, reduce_out, opts);
   }
 
+  Function Function::map(casadi_int n, const std::string& parallelization,
+    const std::vector<bool>& reduce_in,
+    const std::vector<bool>& reduce_out,
+    const Dict& opts) const {
+    return MapSum::create("mapsum_" + str(n) + "_" + name(), parallelization,
+      *this, n, reduce_in, reduce_out, opts);
+  }
+
   Function Function::map(const string& name, const std::string& parallelization, casadi_int n,
       const vector<casadi_int>& reduce_in, const vector<casadi_int>& reduce_out,
         const Dict& opts) const {
@@ -639,6 +647,15 @@ namespace casadi {
     }
   }
 
+  Function
+  Function::map(casadi_int n, const std::string& parallelization, const Dict& opts) const {
+    casadi_assert(n>0, "Degenerate map operation");
+    if (opts.empty() || n==1 || parallelization=="unroll" || parallelization=="inline") {
+      return map(n, parallelization);
+    }
+    return (*this)->map(n, parallelization, opts);
+  }
+
   Function
   Function::map(casadi_int n, const std::string& parallelization) const {
     // Make sure not degenerate
@@ -1316,6 +1333,61 @@ namespace casadi {
     return call_gen(arg, res, always_inline, never_inline);
   }
 
+  vector<DM> Function::call_batch(const vector<DM>& arg,
+                                  const string& parallelization) const {
+    casadi_assert(arg.size()==n_in(), "Incorrect number of inputs: Expected "
+                  + str(n_in()) + ", got " + str(arg.size()));
+    casadi_assert(parallelization=="serial" || parallelization=="thread",
+                  "Unknown parallelization '" + parallelization + "'. "
+                  "Allowed: 'serial', 'thread'.");
+    // Batch size, from the inputs holding multiple input sets
+    casadi_int n = 1;
+    vector<bool> batched(n_in(), false);
+    for (casadi_int i=0; i<n_in(); ++i) {
+      casadi_int ncol = size2_in(i);
+      if (arg[i].size1()==size1_in(i) && ncol>0 && arg[i].size2()>ncol
+          && arg[i].size2()%ncol==0) {
+        casadi_int n_i = arg[i].size2()/ncol;
+        casadi_assert(n==1 || n_i==n, "Inconsistent batch size: Input " + str(i) + " ("
+                      + name_in(i) + ") holds " + str(n_i) + " input sets, expected " + str(n));
+        n = n_i;
+        batched[i] = true;
+      }
+    }
+    // Shared inputs, with the usual conversions
+    vector<DM> arg1 = arg;
+    for (casadi_int i=0; i<n_in(); ++i) {
+      if (batched[i]) arg1[i] = DM(sparsity_in(i));
+    }
+    casadi_int npar = -1;
+    if (!(*this)->matching_arg(arg1, npar)) arg1 = (*this)->replace_arg(arg1, npar);
+    // Project to the sparsity of the function
+    vector<const double*> argp(n_in());
+    for (casadi_int i=0; i<n_in(); ++i) {
+      if (batched[i]) arg1[i] = arg[i];
+      Sparsity sp = batched[i] ? repmat(sparsity_in(i), 1, n) : sparsity_in(i);
+      if (arg1[i].sparsity()!=sp) arg1[i] = project(arg1[i], sp);
+      argp[i] = arg1[i].ptr();
+    }
+    // Allocate outputs
+    vector<DM> res(n_out());
+    vector<double*> resp(n_out());
+    for (casadi_int i=0; i<n_out(); ++i) {
+      res[i] = DM::zeros(repmat(sparsity_out(i), 1, n));
+      resp[i] = res[i].ptr();
+    }
+    // Evaluate
+    if ((*this)->eval_batch(get_ptr(argp), get_ptr(resp), n, batched,
+                            parallelization=="thread")) {
+      casadi_error("Batched evaluation of " + name() + " failed");
+    }
+    return res;
+  }
+
+  DMDict Function::call_batch(const DMDict& arg, const string& parallelization) const {
+    return (*this)->convert_res(call_batch((*this)->convert_arg(arg), parallelization));
+  }
+
   double Function::default_in(casadi_int ind) const {
     return (*this)->get_default_in(ind);
   }
@@ -1518,6 +1590,14 @@ namespace casadi {
     return (*this)->has_sprev();
   }
 
+  std::string Function::jit_status() const {
+    return (*this)->jit_status();
+  }
+
+  bool Function::jit_wait() const {
+    return (*this)->jit_wait();
+  }
+
   bool Function::has_free() const {
     return (*this)->has_free();
   }
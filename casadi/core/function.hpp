@@ -30,6 +30,7 @@
 #include "printable.hpp"
 #include <exception>
 #include <stack>
+#include <functional>
 
 namespace casadi {
 
@@ -38,6 +39,9 @@ namespace casadi {
   class FunctionInternal;
   class SerializingStream;
   class DeserializingStream;
+
+  /** Handle to an asynchronous evaluation */
+  class FunctionFuture;
 #endif // SWIG
 
   /** \brief Function object
@@ -402,7 +406,14 @@ namespace casadi {
     Function jac() const;
 
     ///@{
-    /** \brief Evaluate the function symbolically or numerically  */
+    /** \brief Evaluate the function symbolically or numerically
+
+        For numerical evaluation, entries of \a res whose sparsity pattern already
+        matches the output are written in place. Together with per-thread cached
+        work vectors, repeated calls then do not allocate heap memory. Each thread
+        evaluates with its own memory object, memory object 0 (the one reported
+        by stats()) unless already in use by another thread.
+    */
     void call(const std::vector<DM> &arg, std::vector<DM>& SWIG_OUTPUT(res),
               bool always_inline=false, bool never_inline=false) const;
     void call(const std::vector<SX> &arg, std::vector<SX>& SWIG_OUTPUT(res),
@@ -417,6 +428,39 @@ namespace casadi {
               bool always_inline=false, bool never_inline=false) const;
     ///@}
 
+    ///@{
+    /** \brief Evaluate numerically for a batch of input sets
+
+        An input of dimension n-by-(N*m), where n-by-m is the input dimension, holds N
+        horizontally concatenated input sets, other inputs are shared by all evaluations.
+        The outputs are the N results, horizontally concatenated. N is only known at
+        call time, no Function is created per batch size.
+
+        SX functions are evaluated on blocks of input sets at once, with every
+        instruction applied to the whole block. Other functions are evaluated one
+        input set at a time.
+
+        \param parallelization "serial" or "thread" (persistent thread pool)
+    */
+    std::vector<DM> call_batch(const std::vector<DM>& arg,
+                               const std::string& parallelization="serial") const;
+    DMDict call_batch(const DMDict& arg, const std::string& parallelization="serial") const;
+    ///@}
+
+    /** \brief Status of just-in-time compilation
+
+        "none" without jit, "pending" or "compiling" while a function with option
+        jit_async is evaluated through the interpreter, "ready" once compiled code is
+        used and "failed" if background compilation failed.
+    */
+    std::string jit_status() const;
+
+    /** \brief Wait for background just-in-time compilation, starting it if pending
+
+        Returns true if compiled code is used from now on.
+    */
+    bool jit_wait() const;
+
 #ifndef SWIG
     /// Check if same as another function
     bool operator==(const Function& f) const;
@@ -490,6 +534,33 @@ namespace casadi {
     int operator()(const double** arg, double** res,
         casadi_int* iw, double* w) const;
 
+#ifndef SWIG
+    ///@{
+    /** \brief Evaluate asynchronously
+        Returns immediately with a handle to the evaluation, which starts once all
+        evaluations in \a after have completed and fails if any of them failed.
+        The inputs are copied. The optional callback is invoked on the executing thread
+        upon completion and must not block on other evaluations.
+        See FunctionFuture. */
+    FunctionFuture call_async(const std::vector<DM>& arg) const;
+    FunctionFuture call_async(const std::vector<DM>& arg,
+        const std::vector<FunctionFuture>& after,
+        const std::function<void(const FunctionFuture&)>& callback=nullptr) const;
+    ///@}
+
+    ///@{
+    /** \brief Evaluate asynchronously, caller-owned buffers
+        As above, but the nonzeros are read from and written to the buffers pointed to
+        by \a arg and \a res (null: zero input, output not needed) without copying.
+        The pointer arrays may be freed on return, the buffers must remain valid and
+        the inputs unchanged until the evaluation has completed. */
+    FunctionFuture call_async(const double** arg, double** res) const;
+    FunctionFuture call_async(const double** arg, double** res,
+        const std::vector<FunctionFuture>& after,
+        const std::function<void(const FunctionFuture&)>& callback=nullptr) const;
+    ///@}
+#endif // SWIG
+
     /** \brief Evaluate memory-less SXElem
         Same syntax as the double version, allowing use in templated code
      */
@@ -592,12 +663,21 @@ namespace casadi {
                 s_(N-1) <- f(a_(N-1), p_(N-1))
         \endverbatim
 
-        \param parallelization Type of parallelization used: unroll|serial|openmp
+        \param parallelization Type of parallelization used: unroll|serial|openmp|thread|process
     */
     Function map(casadi_int n, const std::string& parallelization="serial") const;
     Function map(casadi_int n, const std::string& parallelization,
       casadi_int max_num_threads) const;
 
+    /** \brief Create a mapped version of this function, with options
+
+        For the "thread" and "openmp" parallelizations, the options "schedule"
+        (static|dynamic|guided|work_stealing) and "chunk_size" control how the
+        iterations are distributed among threads. Per-thread iteration counts and
+        wall times of the last evaluation are available from stats().
+    */
+    Function map(casadi_int n, const std::string& parallelization, const Dict& opts) const;
+
     ///@{
     /** \brief Map with reduction
       A subset of the inputs are non-repeated and a subset of the outputs summed
@@ -617,6 +697,17 @@ namespace casadi {
       const Dict& opts=Dict()) const;
     ///@}
 
+    /** \brief Map with reduction, evaluated in parallel
+
+      \param parallelization serial|thread. With "thread", the summed outputs are
+      accumulated per block of iterations and combined in a fixed order, so
+      results do not depend on the number of threads.
+    */
+    Function map(casadi_int n, const std::string& parallelization,
+      const std::vector<bool>& reduce_in,
+      const std::vector<bool>& reduce_out=std::vector<bool>(),
+      const Dict& opts=Dict()) const;
+
     /** \brief returns a new function with a selection of inputs/outputs of the original */
     Function slice(const std::string& name, const std::vector<casadi_int>& order_in,
                    const std::vector<casadi_int>& order_out, const Dict& opts=Dict()) const;
@@ -0,0 +1,326 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+
+#include "function_future.hpp"
+#include "function_internal.hpp"
+#include "thread_pool.hpp"
+#include "exception.hpp"
+#include <deque>
+
+namespace casadi {
+
+  struct FunctionFutureState {
+    // Function being evaluated
+    Function f;
+    // Inputs and outputs, when owned by the evaluation
+    std::vector<DM> arg, res;
+    // Pointers to the input and output nonzeros
+    std::vector<const double*> arg_ptr;
+    std::vector<double*> res_ptr;
+    // Evaluation whose outputs are the inputs, kept alive
+    std::shared_ptr<FunctionFutureState> source;
+    // Completion callback
+    FunctionFuture::Callback callback;
+#ifdef CASADI_WITH_THREAD
+    std::mutex mtx;
+    std::condition_variable cv;
+#endif // CASADI_WITH_THREAD
+    // Completed?
+    bool done;
+    // Error message, empty on success
+    std::string error;
+    // Number of dependencies not yet completed, plus one during submission
+    casadi_int pending;
+    // Evaluations waiting for this one
+    std::vector<std::shared_ptr<FunctionFutureState>> dependents;
+
+    FunctionFutureState() : done(false), pending(1) {}
+  };
+
+  // Evaluate and notify waiters, callback and dependents
+  static void future_execute(const std::shared_ptr<FunctionFutureState>& s);
+
+#ifdef CASADI_WITH_THREAD
+  // Process-wide queue of evaluations, served by worker threads started on demand
+  class FutureExecutor {
+  public:
+    static FutureExecutor& instance() {
+      static FutureExecutor e;
+      return e;
+    }
+
+    ~FutureExecutor() {
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+      }
+      cv_.notify_all();
+      for (auto&& t : workers_) t.join();
+    }
+
+    void enqueue(const std::shared_ptr<FunctionFutureState>& s) {
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queue_.push_back(s);
+        // Start another worker if all are busy
+        if (n_idle_ < queue_.size()
+            && workers_.size() < static_cast<size_t>(ThreadPool::size())) {
+          workers_.emplace_back(&FutureExecutor::work, this);
+        }
+      }
+      cv_.notify_one();
+    }
+
+  private:
+    FutureExecutor() : n_idle_(0), stop_(false) {}
+
+    void work() {
+      std::unique_lock<std::mutex> lock(mtx_);
+      while (true) {
+        n_idle_++;
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty();});
+        n_idle_--;
+        if (stop_) return;
+        std::shared_ptr<FunctionFutureState> s = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+        future_execute(s);
+        lock.lock();
+      }
+    }
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<FunctionFutureState>> queue_;
+    std::vector<std::thread> workers_;
+    size_t n_idle_;
+    bool stop_;
+  };
+#endif // CASADI_WITH_THREAD
+
+  // A dependency of s has completed, start s if it was the last one
+  static void future_release(const std::shared_ptr<FunctionFutureState>& s,
+                             const std::string& dep_error) {
+    bool start;
+    {
+#ifdef CASADI_WITH_THREAD
+      std::lock_guard<std::mutex> lock(s->mtx);
+#endif // CASADI_WITH_THREAD
+      if (!dep_error.empty() && s->error.empty()) {
+        s->error = "Dependency failed: " + dep_error;
+      }
+      start = --s->pending==0;
+    }
+    if (!start) return;
+#ifdef CASADI_WITH_THREAD
+    FutureExecutor::instance().enqueue(s);
+#else // CASADI_WITH_THREAD
+    future_execute(s);
+#endif // CASADI_WITH_THREAD
+  }
+
+  static void future_execute(const std::shared_ptr<FunctionFutureState>& s) {
+    // Failed dependencies are not evaluated
+    if (s->error.empty()) {
+      try {
+        // Work vectors of this evaluation
+        size_t sz_arg, sz_res, sz_iw, sz_w;
+        s->f.sz_work(sz_arg, sz_res, sz_iw, sz_w);
+        std::vector<const double*> arg(sz_arg, nullptr);
+        std::vector<double*> res(sz_res, nullptr);
+        std::vector<casadi_int> iw(sz_iw);
+        std::vector<double> w(sz_w);
+        std::copy(s->arg_ptr.begin(), s->arg_ptr.end(), arg.begin());
+        std::copy(s->res_ptr.begin(), s->res_ptr.end(), res.begin());
+        // Evaluate with a memory object of its own
+        scoped_checkout<Function> mem(s->f);
+        if (s->f(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), mem)) {
+          s->error = "Evaluation of " + s->f.name() + " failed";
+        }
+      } catch (std::exception& e) {
+        s->error = e.what();
+      }
+    }
+    // Mark as completed
+    std::vector<std::shared_ptr<FunctionFutureState>> dependents;
+    {
+#ifdef CASADI_WITH_THREAD
+      std::lock_guard<std::mutex> lock(s->mtx);
+#endif // CASADI_WITH_THREAD
+      s->done = true;
+      dependents.swap(s->dependents);
+    }
+#ifdef CASADI_WITH_THREAD
+    s->cv.notify_all();
+#endif // CASADI_WITH_THREAD
+    // Completion callback, must not throw
+    if (s->callback) {
+      try {
+        s->callback(FunctionFuture(s));
+      } catch (std::exception& e) {
+        casadi_warning("Exception in completion callback of " + s->f.name()
+                       + ": " + std::string(e.what()));
+      }
+    }
+    // Start evaluations that were waiting for this one
+    for (auto&& d : dependents) future_release(d, s->error);
+  }
+
+  FunctionFuture::FunctionFuture() {
+  }
+
+  FunctionFuture::FunctionFuture(const std::shared_ptr<FunctionFutureState>& state)
+    : state_(state) {
+  }
+
+  FunctionFuture FunctionFuture::submit(const std::shared_ptr<FunctionFutureState>& state,
+                                        const std::vector<FunctionFuture>& after) {
+    // Register with dependencies that have not completed yet
+    for (auto&& a : after) {
+      casadi_assert(!a.is_null(), "Dependency is a null FunctionFuture");
+      const std::shared_ptr<FunctionFutureState>& d = a.state();
+#ifdef CASADI_WITH_THREAD
+      std::lock_guard<std::mutex> lock(d->mtx);
+#endif // CASADI_WITH_THREAD
+#ifdef CASADI_WITH_THREAD
+      std::lock_guard<std::mutex> lock2(state->mtx);
+#endif // CASADI_WITH_THREAD
+      if (!d->done) {
+        d->dependents.push_back(state);
+        state->pending++;
+      } else if (!d->error.empty() && state->error.empty()) {
+        state->error = "Dependency failed: " + d->error;
+      }
+    }
+    // Start immediately if no dependency is pending
+    future_release(state, std::string());
+    return FunctionFuture(state);
+  }
+
+  bool FunctionFuture::ready() const {
+    casadi_assert(!is_null(), "Null FunctionFuture");
+#ifdef CASADI_WITH_THREAD
+    std::lock_guard<std::mutex> lock(state_->mtx);
+#endif // CASADI_WITH_THREAD
+    return state_->done;
+  }
+
+  void FunctionFuture::wait() const {
+    casadi_assert(!is_null(), "Null FunctionFuture");
+#ifdef CASADI_WITH_THREAD
+    std::unique_lock<std::mutex> lock(state_->mtx);
+    state_->cv.wait(lock, [this] { return state_->done;});
+#endif // CASADI_WITH_THREAD
+  }
+
+  bool FunctionFuture::success() const {
+    wait();
+    return state_->error.empty();
+  }
+
+  std::string FunctionFuture::error() const {
+    wait();
+    return state_->error;
+  }
+
+  const std::vector<DM>& FunctionFuture::get() const {
+    wait();
+    casadi_assert(state_->error.empty(), state_->error);
+    return state_->res;
+  }
+
+  FunctionFuture FunctionFuture::then(const Function& f, const Callback& callback) const {
+    casadi_assert(!is_null(), "Null FunctionFuture");
+    const Function& g = state_->f;
+    casadi_assert(f.n_in()==g.n_out(), "Cannot chain " + g.name() + " with "
+      + f.name() + ": Expected " + str(g.n_out()) + " inputs, got " + str(f.n_in()));
+    for (casadi_int i=0; i<f.n_in(); ++i) {
+      casadi_assert(f.sparsity_in(i)==g.sparsity_out(i), "Cannot chain " + g.name()
+        + " with " + f.name() + ": Sparsity mismatch for input " + str(i) + ", expected "
+        + g.sparsity_out(i).dim() + ", got " + f.sparsity_in(i).dim());
+    }
+    auto s = std::make_shared<FunctionFutureState>();
+    s->f = f;
+    s->source = state_;
+    s->arg_ptr.assign(state_->res_ptr.begin(), state_->res_ptr.end());
+    s->res.resize(f.n_out());
+    s->res_ptr.resize(f.n_out());
+    for (casadi_int i=0; i<f.n_out(); ++i) {
+      s->res[i] = DM::zeros(f.sparsity_out(i));
+      s->res_ptr[i] = s->res[i].ptr();
+    }
+    s->callback = callback;
+    return submit(s, {*this});
+  }
+
+  FunctionFuture Function::call_async(const std::vector<DM>& arg) const {
+    return call_async(arg, std::vector<FunctionFuture>());
+  }
+
+  FunctionFuture Function::call_async(const std::vector<DM>& arg,
+      const std::vector<FunctionFuture>& after,
+      const std::function<void(const FunctionFuture&)>& callback) const {
+    // Inputs are copied, with the sparsity of the function
+    casadi_int npar = -1;
+    std::vector<DM> arg1 = (*this)->matching_arg(arg, npar) ? arg :
+      (*this)->replace_arg(arg, npar);
+    auto s = std::make_shared<FunctionFutureState>();
+    s->f = *this;
+    s->arg.resize(n_in());
+    s->arg_ptr.resize(n_in());
+    for (casadi_int i=0; i<n_in(); ++i) {
+      s->arg[i] = arg1[i].sparsity()==sparsity_in(i) ? arg1[i] :
+        project(arg1[i], sparsity_in(i));
+      s->arg_ptr[i] = s->arg[i].ptr();
+    }
+    s->res.resize(n_out());
+    s->res_ptr.resize(n_out());
+    for (casadi_int i=0; i<n_out(); ++i) {
+      s->res[i] = DM::zeros(sparsity_out(i));
+      s->res_ptr[i] = s->res[i].ptr();
+    }
+    s->callback = callback;
+    return FunctionFuture::submit(s, after);
+  }
+
+  FunctionFuture Function::call_async(const double** arg, double** res) const {
+    return call_async(arg, res, std::vector<FunctionFuture>());
+  }
+
+  FunctionFuture Function::call_async(const double** arg, double** res,
+      const std::vector<FunctionFuture>& after,
+      const std::function<void(const FunctionFuture&)>& callback) const {
+    // Only the pointers are copied, the buffers belong to the caller
+    auto s = std::make_shared<FunctionFutureState>();
+    s->f = *this;
+    s->arg_ptr.assign(arg, arg + n_in());
+    s->res_ptr.assign(res, res + n_out());
+    s->callback = callback;
+    return FunctionFuture::submit(s, after);
+  }
+
+} // namespace casadi
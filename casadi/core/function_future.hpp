@@ -0,0 +1,99 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_FUNCTION_FUTURE_HPP
+#define CASADI_FUNCTION_FUTURE_HPP
+
+#include "function.hpp"
+#include <functional>
+#include <memory>
+
+namespace casadi {
+
+#ifndef SWIG
+  /// Internal state of an asynchronous evaluation
+  struct FunctionFutureState;
+
+  /** \brief Handle to an asynchronous Function evaluation
+
+      Returned by Function::call_async. The evaluation runs on a process-wide
+      executor with GlobalOptions::max_num_threads worker threads (0: number
+      of cores), using its own memory object and work vectors. Copying a
+      handle is cheap, all copies refer to the same evaluation.
+      Without thread support (WITH_THREAD=OFF), evaluations run synchronously.
+  */
+  class CASADI_EXPORT FunctionFuture {
+  public:
+    /// Completion callback, invoked on the executing thread
+    typedef std::function<void(const FunctionFuture&)> Callback;
+
+    /// Default constructor, null handle
+    FunctionFuture();
+
+    /// Is the handle null?
+    bool is_null() const { return !state_;}
+
+    /// Has the evaluation completed (successfully or not)?
+    bool ready() const;
+
+    /// Block until the evaluation has completed
+    void wait() const;
+
+    /// Block until completed, returns false if the evaluation failed
+    bool success() const;
+
+    /// Block until completed, error message if the evaluation failed
+    std::string error() const;
+
+    /** \brief Block until completed and get the outputs
+        Throws if the evaluation failed. For calls with caller-owned output
+        buffers, the outputs are in those buffers and an empty vector is returned. */
+    const std::vector<DM>& get() const;
+
+    /** \brief Evaluate f on the outputs of this evaluation once it has completed
+        The outputs are passed without copying. */
+    FunctionFuture then(const Function& f, const Callback& callback=nullptr) const;
+
+    /// \cond INTERNAL
+    /// Submit an evaluation to the executor once all dependencies have completed
+    static FunctionFuture submit(const std::shared_ptr<FunctionFutureState>& state,
+                                 const std::vector<FunctionFuture>& after);
+
+    /// Create a handle to an existing evaluation
+    explicit FunctionFuture(const std::shared_ptr<FunctionFutureState>& state);
+
+    /// Access the state
+    const std::shared_ptr<FunctionFutureState>& state() const { return state_;}
+    /// \endcond
+
+  private:
+    std::shared_ptr<FunctionFutureState> state_;
+  };
+#endif // SWIG
+
+} // namespace casadi
+
+#endif // CASADI_FUNCTION_FUTURE_HPP
@@ -41,6 +41,7 @@
 #include "conic_impl.hpp"
 #include "integrator_impl.hpp"
 #include "external_impl.hpp"
+#include "thread_pool.hpp"
 
 #include <cctype>
 #include <typeinfo>
@@ -59,6 +60,7 @@ namespace casadi {
     verbose_ = false;
     print_time_ = false;
     record_time_ = false;
+    init_mem_pool();
   }
 
   FunctionInternal::FunctionInternal(const std::string& name) : ProtoFunction(name) {
@@ -78,6 +80,8 @@ namespace casadi {
     never_inline_ = false;
     jac_penalty_ = 2;
     max_num_dir_ = GlobalOptions::getMaxNumDir();
+    jac_parallelization_ = "serial";
+    deserialized_version_ = 0;
     user_data_ = nullptr;
     regularity_check_ = false;
     inputs_check_ = true;
@@ -86,6 +90,10 @@ namespace casadi {
     jit_serialize_ = "source";
     jit_base_name_ = "jit_tmp";
     jit_temp_suffix_ = true;
+    jit_async_ = false;
+    jit_threshold_ = 0;
+    jit_state_ = JIT_NONE;
+    jit_calls_ = 0;
     compiler_plugin_ = "clang";
 
     eval_ = nullptr;
@@ -114,10 +122,18 @@ namespace casadi {
   }
 
   ProtoFunction::~ProtoFunction() {
-    for (void* m : mem_) {
-      if (m!=nullptr) casadi_warning("Memory object has not been properly freed");
+    for (casadi_int i=0; i<n_mem_; ++i) {
+      if (mem_slot(i).mem!=nullptr) casadi_warning("Memory object has not been properly freed");
     }
-    mem_.clear();
+    for (auto&& b : mem_block_) delete[] b.load();
+  }
+
+  void ProtoFunction::init_mem_pool() {
+    for (auto&& b : mem_block_) b = nullptr;
+    n_mem_ = 0;
+    unused_ = 0;
+    n_mem_contention_ = 0;
+    mem0_claimed_ = false;
   }
 
   FunctionInternal::~FunctionInternal() {
@@ -241,6 +257,14 @@ namespace casadi {
         "This is desired for thread-safety. "
         "This behaviour may defeat caching compiler wrappers. "
         "Default: true"}},
+      {"jit_async",
+       {OT_BOOL,
+        "Compile in a background thread and evaluate through the interpreter "
+        "until the compiled code is loaded. Default: false"}},
+      {"jit_threshold",
+       {OT_INT,
+        "With jit_async, number of calls before background compilation starts. "
+        "Default: 0 (start when the function is created)"}},
       {"compiler",
        {OT_STRING,
         "Just-in-time compiler plugin to be used."}},
@@ -256,6 +280,11 @@ namespace casadi {
        {OT_INT,
         "Specify the maximum number of directions for derivative functions."
         " Overrules the builtin optimized_num_dir."}},
+      {"jac_parallelization",
+       {OT_STRING,
+        "Evaluate the batches of directional derivatives of the numeric Jacobian "
+        "(jacobian()) serially or concurrently on the thread pool: serial|thread. "
+        "[default: serial]"}},
       {"enable_forward",
        {OT_BOOL,
         "Enable derivative calculation using generated functions for"
@@ -353,12 +382,15 @@ namespace casadi {
     opts["jit_options"] = jit_options_;
     opts["jit_name"] = jit_base_name_;
     opts["jit_temp_suffix"] = jit_temp_suffix_;
+    opts["jit_async"] = jit_async_;
+    opts["jit_threshold"] = jit_threshold_;
     opts["derivative_of"] = derivative_of_;
     opts["ad_weight"] = ad_weight_;
     opts["ad_weight_sp"] = ad_weight_sp_;
     opts["always_inline"] = always_inline_;
     opts["never_inline"] = never_inline_;
     opts["max_num_dir"] = max_num_dir_;
+    opts["jac_parallelization"] = jac_parallelization_;
     opts["enable_forward"] = enable_forward_op_;
     opts["enable_reverse"] = enable_reverse_op_;
     opts["enable_jacobian"] = enable_jacobian_op_;
@@ -418,6 +450,11 @@ namespace casadi {
         jit_base_name_ = op.second.to_string();
       } else if (op.first=="jit_temp_suffix") {
         jit_temp_suffix_ = op.second;
+      } else if (op.first=="jit_async") {
+        jit_async_ = op.second;
+      } else if (op.first=="jit_threshold") {
+        jit_threshold_ = op.second;
+        casadi_assert(jit_threshold_>=0, "Option 'jit_threshold' must be non-negative");
       } else if (op.first=="derivative_of") {
         derivative_of_ = op.second;
       } else if (op.first=="ad_weight") {
@@ -426,6 +463,10 @@ namespace casadi {
         ad_weight_sp_ = op.second;
       } else if (op.first=="max_num_dir") {
         max_num_dir_ = op.second;
+      } else if (op.first=="jac_parallelization") {
+        jac_parallelization_ = op.second.to_string();
+        casadi_assert(jac_parallelization_=="serial" || jac_parallelization_=="thread",
+          "Option 'jac_parallelization' must be 'serial' or 'thread'");
       } else if (op.first=="enable_forward") {
         enable_forward_op_ = op.second;
       } else if (op.first=="enable_reverse") {
@@ -565,23 +606,13 @@ namespace casadi {
         jit_name_ = std::string(jit_name_.begin(), jit_name_.begin()+jit_name_.size()-2);
       }
       if (has_codegen()) {
-        if (compiler_.is_null()) {
-          if (verbose_) casadi_message("Codegenerating function '" + name_ + "'.");
-          // JIT everything
-          Dict opts;
-          // Override the default to avoid random strings in the generated code
-          opts["prefix"] = "jit";
-          CodeGenerator gen(jit_name_, opts);
-          gen.add(self());
-          if (verbose_) casadi_message("Compiling function '" + name_ + "'..");
-          compiler_ = Importer(gen.generate(), compiler_plugin_, jit_options_);
-          if (verbose_) casadi_message("Compiling function '" + name_ + "' done.");
+        if (jit_async_ && compiler_.is_null()) {
+          // Interpret until compiled
+          jit_state_ = JIT_PENDING;
+        } else {
+          jit_compile();
+          jit_state_ = JIT_READY;
         }
-        // Try to load
-        eval_ = (eval_t) compiler_.get_function(name_);
-        checkout_ = (casadi_checkout_t) compiler_.get_function(name_ + "checkout");
-        release_ = (casadi_release_t) compiler_.get_function(name_ + "release");
-        casadi_assert(eval_!=nullptr, "Cannot load JIT'ed function.");
       } else {
         // Just jit dependencies
         jit_dependencies(jit_name_);
@@ -593,6 +624,9 @@ namespace casadi {
 
     // Dump if requested
     if (dump_) dump();
+
+    // Background compilation once the function is complete
+    if (jit_state_==JIT_PENDING && jit_threshold_==0) jit_launch();
   }
 
   void ProtoFunction::finalize() {
@@ -715,8 +749,12 @@ namespace casadi {
     // Reset statistics
     for (auto&& s : m->fstats) s.second.reset();
     if (m->t_total) m->t_total->tic();
+    // Promote to compiled code after enough calls
+    if (jit_state_==JIT_PENDING && ++jit_calls_>=jit_threshold_) jit_launch();
+
     int ret;
-    if (eval_) {
+    eval_t eval_c = eval_;
+    if (eval_c) {
       int mem = 0;
       if (checkout_) {
 #ifdef CASADI_WITH_THREAD
@@ -724,7 +762,7 @@ namespace casadi {
 #endif //CASADI_WITH_THREAD
         mem = checkout_();
       }
-      ret = eval_(arg, res, iw, w, mem);
+      ret = eval_c(arg, res, iw, w, mem);
       if (release_) {
 #ifdef CASADI_WITH_THREAD
     std::lock_guard<std::mutex> lock(mtx_);
@@ -830,9 +868,10 @@ namespace casadi {
     }
   }
 
-  Function FunctionInternal::map(casadi_int n, const std::string& parallelization) const {
+  Function FunctionInternal::map(casadi_int n, const std::string& parallelization,
+      const Dict& opts) const {
     Function f;
-    if (parallelization=="serial") {
+    if (parallelization=="serial" && opts.empty()) {
       // Serial maps are cached
       string fname = "map" + str(n) + "_" + name_;
       if (!incache(fname, f)) {
@@ -844,7 +883,7 @@ namespace casadi {
       }
     } else {
       // Non-serial maps are not cached
-      f = Map::create(parallelization, self(), n);
+      f = Map::create(parallelization, self(), n, opts);
     }
     return f;
   }
@@ -2061,7 +2100,7 @@ namespace casadi {
 
   Function FunctionInternal::jacobian() const {
     // Used wrapped function if jacobian not available
-    if (!has_jacobian()) {
+    if (!has_jacobian() && jac_parallelization_=="serial") {
       // Derivative information must be available
       casadi_assert(has_derivative(),
                             "Derivatives cannot be calculated for " + name_);
@@ -2089,8 +2128,14 @@ namespace casadi {
     opts["derivative_of"] = self();
 
     // Generate derivative function
-    casadi_assert_dev(enable_jacobian_);
-    Function ret = get_jacobian(name, inames, onames, opts);
+    Function ret;
+    if (jac_parallelization_=="serial") {
+      casadi_assert_dev(enable_jacobian_);
+      ret = get_jacobian(name, inames, onames, opts);
+    } else {
+      casadi_assert(has_derivative(), "Derivatives cannot be calculated for " + name_);
+      ret = get_jacobian_parallel(name, inames, onames, opts);
+    }
 
     // Consistency check
     casadi_assert_dev(ret.n_in()==n_in_ + n_out_);
@@ -2109,6 +2154,91 @@ namespace casadi {
     casadi_error("'get_jacobian' not defined for " + class_name());
   }
 
+  Function FunctionInternal::
+  get_jacobian_parallel(const std::string& name,
+                        const std::vector<std::string>& inames,
+                        const std::vector<std::string>& onames,
+                        const Dict& opts) const {
+    // Nondifferentiated inputs and outputs
+    vector<MX> arg = mx_in(), res = mx_out();
+    MX x = veccat(arg), y = veccat(res);
+
+    // Flattened function: all inputs to all outputs
+    Dict tmp_opts;
+    tmp_opts["ad_weight"] = ad_weight();
+    tmp_opts["ad_weight_sp"] = sp_weight();
+    tmp_opts["max_num_dir"] = max_num_dir_;
+    Function tmp("flattened_" + name, {x}, {veccat(self()(arg))}, tmp_opts);
+
+    // Jacobian sparsity and seed matrices by graph coloring
+    const Sparsity& sp_x = x.sparsity();
+    const Sparsity& sp_y = tmp.sparsity_out(0);
+    Sparsity D1, D2;
+    tmp->get_partition(0, 0, D1, D2, true, false, true, true);
+    Sparsity sp = tmp.sparsity_jac(0, 0, false, false);
+    bool fwd = !D1.is_null();
+    const Sparsity& D = fwd ? D1 : D2;
+    const Sparsity& sp_seed = fwd ? sp_x : sp_y;
+    const Sparsity& sp_sens = fwd ? sp_y : sp_x;
+    casadi_int n_dir = D.size2();
+
+    // Directions per batch and number of batches
+    casadi_int max_ndir = std::max(std::min(max_num_dir_, n_dir), casadi_int(1));
+    if (fwd) {
+      while (!tmp->has_forward(max_ndir)) max_ndir/=2;
+    } else {
+      while (!tmp->has_reverse(max_ndir)) max_ndir/=2;
+    }
+    casadi_int n_batch = (n_dir + max_ndir - 1)/max_ndir;
+
+    // Seeds of all batches, color of each seeded nonzero
+    vector<casadi_int> seed_row, seed_col, color(sp_seed.nnz(), -1);
+    const casadi_int* D_colind = D.colind();
+    const casadi_int* D_row = D.row();
+    const casadi_int* seed_sp_row = sp_seed.row();
+    for (casadi_int d=0; d<n_dir; ++d) {
+      for (casadi_int el=D_colind[d]; el<D_colind[d+1]; ++el) {
+        seed_row.push_back(seed_sp_row[D_row[el]]);
+        seed_col.push_back(d);
+        color[D_row[el]] = d;
+      }
+    }
+    DM seed = DM::triplet(seed_row, seed_col, vector<double>(seed_row.size(), 1.),
+                          sp_seed.size1(), n_batch*max_ndir);
+
+    // Evaluate the batches concurrently, nondifferentiated arguments shared
+    Function dfcn = fwd ? tmp.forward(max_ndir) : tmp.reverse(max_ndir);
+    Function dmap = dfcn.map(n_batch, "thread", {true, true, false}, {false});
+    MX sens = dmap(vector<MX>{x, y, seed}).at(0);
+
+    // Nonzero index of the Jacobian entries in the sensitivities
+    vector<casadi_int> lookup_seed(sp_seed.size1(), -1);
+    for (casadi_int k=0; k<sp_seed.nnz(); ++k) lookup_seed[seed_sp_row[k]] = k;
+    const Sparsity& sp_s = sens.sparsity();
+    casadi_assert_dev(sp_s.size1()==sp_sens.size1());
+    vector<casadi_int> nz;
+    nz.reserve(sp.nnz());
+    const casadi_int* sp_colind = sp.colind();
+    const casadi_int* sp_row = sp.row();
+    for (casadi_int c=0; c<sp.size2(); ++c) {
+      for (casadi_int el=sp_colind[c]; el<sp_colind[c+1]; ++el) {
+        // Seeded and sensitivity element
+        casadi_int i_seed = fwd ? c : sp_row[el], i_sens = fwd ? sp_row[el] : c;
+        casadi_int k = lookup_seed[i_seed];
+        casadi_assert_dev(k>=0 && color[k]>=0);
+        nz.push_back(sp_s.get_nz(i_sens, color[k]));
+      }
+    }
+    MX J = sens->get_nzref(sp, nz);
+
+    // Filter out parts that are non-differentiable
+    J = project(J, jacobian_sparsity_filter(J.sparsity()));
+
+    // Assemble the Jacobian function
+    arg.insert(arg.end(), res.begin(), res.end());
+    return Function(name, arg, {J}, inames, onames, opts);
+  }
+
   Function FunctionInternal::
   get_jac(const std::string& name,
                const std::vector<std::string>& inames,
@@ -2145,6 +2275,10 @@ namespace casadi {
                             "casadi_int* iw, casadi_real* w, int mem)";
   }
 
+  void FunctionInternal::codegen_batch_body(CodeGenerator& g) const {
+    casadi_error("'codegen_batch_body' not defined for " + class_name());
+  }
+
   void FunctionInternal::codegen_init_mem(CodeGenerator& g) const {
     g << "return 0;\n";
   }
@@ -2154,7 +2288,11 @@ namespace casadi {
     if (needs_mem) {
     std::string name = codegen_name(g, false);
     std::string mem_counter = g.shorthand(name + "_mem_counter");
-    g << "return " + mem_counter + "++;\n";
+    if (g.thread_safe) {
+      g << "return casadi_atomic_fetch_add(&" + mem_counter + ", 1);\n";
+    } else {
+      g << "return " + mem_counter + "++;\n";
+    }
     }
   }
 
@@ -2249,10 +2387,6 @@ namespace casadi {
     // Codegen sparsities
     codegen_sparsities(g);
 
-    // Determine work vector size
-    casadi_int sz_w_codegen = sz_w();
-    if (is_a("SXFunction", true) && !g.avoid_stack()) sz_w_codegen = 0;
-
     // Function that returns work vector lengths
     g << g.declare(
         "int " + name_ + "_work(casadi_int *sz_arg, casadi_int* sz_res, "
@@ -2261,7 +2395,7 @@ namespace casadi {
       << "if (sz_arg) *sz_arg = " << sz_arg() << ";\n"
       << "if (sz_res) *sz_res = " << sz_res() << ";\n"
       << "if (sz_iw) *sz_iw = " << sz_iw() << ";\n"
-      << "if (sz_w) *sz_w = " << sz_w_codegen << ";\n"
+      << "if (sz_w) *sz_w = " << codegen_sz_w(g) << ";\n"
       << "return 0;\n"
       << "}\n\n";
 
@@ -2277,7 +2411,7 @@ namespace casadi {
 
       // Work vectors, including input and output buffers
       casadi_int i_nnz = nnz_in(), o_nnz = nnz_out();
-      size_t sz_w = this->sz_w();
+      size_t sz_w = codegen_sz_w(g);
       for (casadi_int i=0; i<n_in_; ++i) {
         const Sparsity& s = sparsity_in_[i];
         sz_w = max(sz_w, static_cast<size_t>(s.size1())); // To be able to copy a column
@@ -2352,7 +2486,7 @@ namespace casadi {
 
 
       // Work vectors and input and output buffers
-      size_t nr = sz_w() + nnz_in() + nnz_out();
+      size_t nr = codegen_sz_w(g) + nnz_in() + nnz_out();
       g << CodeGenerator::array("casadi_int", "iw", sz_iw())
         << CodeGenerator::array("casadi_real", "w", nr);
 
@@ -2394,6 +2528,61 @@ namespace casadi {
         << "}\n\n";
     }
 
+    if (g.benchmark) {
+      g.add_auxiliary(CodeGenerator::AUX_BENCHMARK);
+
+      // Declare wrapper
+      g << "casadi_int benchmark_" << name_ << "(casadi_int argc, char* argv[]) {\n";
+
+      g << "casadi_int j;\n";
+      g << "casadi_real* a;\n";
+      g << "double v;\n";
+      g << "long n = 1000, n_warmup = 100;\n";
+      g << "FILE* fp;\n";
+
+      // Work vectors and input and output buffers
+      size_t nr = codegen_sz_w(g) + nnz_in() + nnz_out();
+      g << CodeGenerator::array("casadi_int", "iw", sz_iw())
+        << CodeGenerator::array("casadi_real", "w", nr);
+      g << "const casadi_real* arg[" << sz_arg() << "];\n";
+      g << "casadi_real* res[" << sz_res() << "];\n";
+
+      casadi_int off=0;
+      for (casadi_int i=0; i<n_in_; ++i) {
+        g << "arg[" << i << "] = w+" << off << ";\n";
+        off += nnz_in(i);
+      }
+      for (casadi_int i=0; i<n_out_; ++i) {
+        g << "res[" << i << "] = w+" << off << ";\n";
+        off += nnz_out(i);
+      }
+
+      // Inputs from file in the format of generate_in, or "-" for stdin
+      g << "if (argc<1) {\n"
+        << "fprintf(stderr, \"Usage: benchmark " << name_
+        << " <input file> [evaluations] [warmup evaluations]\\n\");\n"
+        << "return 1;\n"
+        << "}\n"
+        << "fp = strcmp(argv[0], \"-\")==0 ? stdin : fopen(argv[0], \"r\");\n"
+        << "if (!fp) {\n"
+        << "fprintf(stderr, \"Cannot open %s\\n\", argv[0]);\n"
+        << "return 1;\n"
+        << "}\n"
+        << "a = w;\n"
+        << "for (j=0; j<" << nnz_in() << "; ++j) {\n"
+        << "if (fscanf(fp, \"%lg\", &v)<=0) return 2;\n"
+        << "*a++ = v;\n"
+        << "}\n"
+        << "if (fp!=stdin) fclose(fp);\n"
+        << "if (argc>1) n = atol(argv[1]);\n"
+        << "if (argc>2) n_warmup = atol(argv[2]);\n";
+
+      // Time evaluations
+      g << "return " << g.shorthand("bench") << "(" << name_ << ", arg, res, iw, w+" << off
+        << ", n, n_warmup);\n"
+        << "}\n\n";
+    }
+
     if (g.with_mem) {
       // Allocate memory
       g << g.declare("casadi_functions* " + name_ + "_functions(void)") << " {\n"
@@ -2422,6 +2611,75 @@ namespace casadi {
     g.flush(g.body);
   }
 
+  void FunctionInternal::jit_compile() {
+    if (compiler_.is_null()) {
+      if (verbose_) casadi_message("Codegenerating function '" + name_ + "'.");
+      // JIT everything
+      Dict opts;
+      // Override the default to avoid random strings in the generated code
+      opts["prefix"] = "jit";
+      CodeGenerator gen(jit_name_, opts);
+      gen.add(self());
+      if (verbose_) casadi_message("Compiling function '" + name_ + "'..");
+      compiler_ = Importer(gen.generate(), compiler_plugin_, jit_options_);
+      if (verbose_) casadi_message("Compiling function '" + name_ + "' done.");
+    }
+    // Try to load, publish eval_ last so that concurrent calls see a consistent state
+    checkout_ = (casadi_checkout_t) compiler_.get_function(name_ + "checkout");
+    release_ = (casadi_release_t) compiler_.get_function(name_ + "release");
+    eval_t eval = (eval_t) compiler_.get_function(name_);
+    casadi_assert(eval!=nullptr, "Cannot load JIT'ed function.");
+    eval_ = eval;
+  }
+
+  void FunctionInternal::jit_launch() const {
+    // Only the first caller starts the compilation
+    int state = JIT_PENDING;
+    if (!jit_state_.compare_exchange_strong(state, JIT_COMPILING)) return;
+    // The task keeps the function alive until it is done
+    Function f = self();
+    auto task = [f]() {
+      FunctionInternal* fi = f.get();
+      try {
+        fi->jit_compile();
+        fi->jit_state_ = JIT_READY;
+      } catch (std::exception& e) {
+        casadi_warning("Background compilation of '" + f.name() + "' failed, "
+                       "continuing interpreted: " + std::string(e.what()));
+        fi->jit_state_ = JIT_FAILED;
+      }
+#ifdef CASADI_WITH_THREAD
+      std::lock_guard<std::mutex> lock(fi->jit_mtx_);
+      fi->jit_cv_.notify_all();
+#endif // CASADI_WITH_THREAD
+    };
+#ifdef CASADI_WITH_THREAD
+    std::thread(task).detach();
+#else // CASADI_WITH_THREAD
+    task();
+#endif // CASADI_WITH_THREAD
+  }
+
+  std::string FunctionInternal::jit_status() const {
+    switch (jit_state_) {
+      case JIT_PENDING: return "pending";
+      case JIT_COMPILING: return "compiling";
+      case JIT_READY: return "ready";
+      case JIT_FAILED: return "failed";
+      default: return "none";
+    }
+  }
+
+  bool FunctionInternal::jit_wait() const {
+    // Start pending compilation rather than waiting for calls that may never come
+    jit_launch();
+#ifdef CASADI_WITH_THREAD
+    std::unique_lock<std::mutex> lock(jit_mtx_);
+    jit_cv_.wait(lock, [this]() { return jit_state_!=JIT_COMPILING;});
+#endif // CASADI_WITH_THREAD
+    return jit_state_==JIT_READY;
+  }
+
   std::string FunctionInternal::codegen_name(const CodeGenerator& g, bool ns) const {
     if (ns) {
       // Get the index of the function
@@ -2582,6 +2840,9 @@ namespace casadi {
       stats["t_wall_" +s.first] = s.second.t_wall;
       stats["t_proc_" +s.first] = s.second.t_proc;
     }
+    // Memory pool statistics
+    stats["n_mem"] = n_mem_.load();
+    stats["n_mem_contention"] = n_mem_contention_.load();
     return stats;
   }
 
@@ -3143,10 +3404,14 @@ namespace casadi {
   }
 
   void ProtoFunction::clear_mem() {
-    for (auto&& i : mem_) {
-      if (i!=nullptr) free_mem(i);
+    for (casadi_int i=0; i<n_mem_; ++i) {
+      void* m = mem_slot(i).mem.exchange(nullptr);
+      if (m!=nullptr) free_mem(m);
     }
-    mem_.clear();
+    // Blocks are kept for reuse, freed in the destructor
+    n_mem_ = 0;
+    unused_ = 0;
+    mem0_claimed_ = false;
   }
 
   size_t FunctionInternal::get_n_in() {
@@ -3221,38 +3486,84 @@ namespace casadi {
     return Sparsity::scalar();
   }
 
+  ProtoFunction::MemSlot& ProtoFunction::mem_slot(casadi_int ind) const {
+    // Block b holds the entries 8*(2^b-1) to 8*(2^(b+1)-1)-1
+    casadi_int k = ind + 8, b = -3;
+    for (casadi_int j=k; j>1; j>>=1) b++;
+    return mem_block_[b].load(std::memory_order_acquire)[k - (casadi_int(8) << b)];
+  }
+
   void* ProtoFunction::memory(int ind) const {
-#ifdef CASADI_WITH_THREAD
-    std::lock_guard<std::mutex> lock(mtx_);
-#endif //CASADI_WITH_THREAD
-    return mem_.at(ind);
+    casadi_assert(ind>=0 && ind<n_mem_.load(std::memory_order_acquire),
+      "Memory object " + str(ind) + " does not exist");
+    return mem_slot(ind).mem.load(std::memory_order_acquire);
   }
 
   int ProtoFunction::checkout() const {
+    // Use an unused memory object, if any
+    std::uint64_t head = unused_.load(std::memory_order_acquire);
+    while (head & 0xffffffff) {
+      casadi_int ind = (head & 0xffffffff) - 1;
+      std::uint64_t next = (((head >> 32) + 1) << 32)
+        | mem_slot(ind).next.load(std::memory_order_relaxed);
+      if (unused_.compare_exchange_weak(head, next,
+          std::memory_order_acquire, std::memory_order_acquire)) return ind;
+      n_mem_contention_++;
+    }
+    // Allocate a new memory object, rare so a lock is acceptable
 #ifdef CASADI_WITH_THREAD
     std::lock_guard<std::mutex> lock(mtx_);
 #endif //CASADI_WITH_THREAD
-    if (unused_.empty()) {
-      // Allocate a new memory object
-      void* m = alloc_mem();
-      mem_.push_back(m);
-      if (init_mem(m)) {
-        casadi_error("Failed to create or initialize memory object");
-      }
-      return mem_.size()-1;
-    } else {
-      // Use an unused memory object
-      casadi_int m = unused_.top();
-      unused_.pop();
-      return m;
+    casadi_int ind = n_mem_.load(std::memory_order_relaxed);
+    casadi_assert(ind < 0x7fffffff, "Too many memory objects");
+    // Allocate a new block, if needed
+    casadi_int k = ind + 8, b = -3;
+    for (casadi_int j=k; j>1; j>>=1) b++;
+    if (mem_block_[b].load(std::memory_order_relaxed)==nullptr) {
+      casadi_int sz = casadi_int(8) << b;
+      MemSlot* block = new MemSlot[sz];
+      for (casadi_int i=0; i<sz; ++i) {
+        block[i].mem = nullptr;
+        block[i].next = 0;
+      }
+      mem_block_[b].store(block, std::memory_order_release);
     }
+    void* m = alloc_mem();
+    mem_slot(ind).mem.store(m, std::memory_order_release);
+    n_mem_.store(ind + 1, std::memory_order_release);
+    if (init_mem(m)) {
+      casadi_error("Failed to create or initialize memory object");
+    }
+    return ind;
   }
 
   void ProtoFunction::release(int mem) const {
-#ifdef CASADI_WITH_THREAD
-    std::lock_guard<std::mutex> lock(mtx_);
-#endif //CASADI_WITH_THREAD
-    unused_.push(mem);
+    MemSlot& s = mem_slot(mem);
+    std::uint64_t head = unused_.load(std::memory_order_relaxed);
+    while (true) {
+      s.next.store(head & 0xffffffff, std::memory_order_relaxed);
+      std::uint64_t top = (((head >> 32) + 1) << 32) | static_cast<std::uint64_t>(mem + 1);
+      if (unused_.compare_exchange_weak(head, top,
+          std::memory_order_release, std::memory_order_relaxed)) break;
+      n_mem_contention_++;
+    }
+  }
+
+  int ProtoFunction::checkout_first() const {
+    // Memory object 0 is checked out in finalize and never released
+    bool claimed = false;
+    if (mem0_claimed_.compare_exchange_strong(claimed, true, std::memory_order_acquire)) {
+      return 0;
+    }
+    return checkout();
+  }
+
+  void ProtoFunction::release_first(int mem) const {
+    if (mem==0) {
+      mem0_claimed_.store(false, std::memory_order_release);
+    } else {
+      release(mem);
+    }
   }
 
   Function FunctionInternal::
@@ -3372,6 +3683,60 @@ namespace casadi {
     }
   }
 
+  int FunctionInternal::eval_batch(const double** arg, double** res, casadi_int n,
+      const std::vector<bool>& batched_in, bool parallel) const {
+    // Number of threads taking part
+    casadi_int n_threads = parallel ? std::max(std::min(ThreadPool::size(), n), casadi_int(1)) : 1;
+    // Work vectors of each thread
+    std::vector<std::vector<const double*>> arg1(n_threads, std::vector<const double*>(sz_arg()));
+    std::vector<std::vector<double*>> res1(n_threads, std::vector<double*>(sz_res()));
+    std::vector<std::vector<casadi_int>> iw1(n_threads, std::vector<casadi_int>(sz_iw()));
+    std::vector<std::vector<double>> w1(n_threads, std::vector<double>(sz_w()));
+    // Evaluation k on thread t
+    auto eval_k = [&](casadi_int k, casadi_int t, int mem) {
+      const double** a = get_ptr(arg1[t]);
+      double** r = get_ptr(res1[t]);
+      for (casadi_int i=0; i<n_in_; ++i) {
+        a[i] = arg[i] && batched_in[i] ? arg[i] + k*nnz_in(i) : arg[i];
+      }
+      for (casadi_int i=0; i<n_out_; ++i) {
+        r[i] = res[i] ? res[i] + k*nnz_out(i) : nullptr;
+      }
+      return eval_gen(a, r, get_ptr(iw1[t]), get_ptr(w1[t]), memory(mem));
+    };
+    // Serial evaluation
+    if (n_threads==1) {
+      scoped_checkout<FunctionInternal> mem(*this);
+      for (casadi_int k=0; k<n; ++k) {
+        if (eval_k(k, 0, mem)) return 1;
+      }
+      return 0;
+    }
+    // Evaluation on the thread pool, one memory object per thread
+    std::vector<int> mem(n_threads);
+    for (casadi_int t=0; t<n_threads; ++t) mem[t] = checkout();
+    std::vector<int> flag(n_threads, 0);
+    std::vector<std::string> error(n_threads);
+    ThreadPool::instance().run(n, 0, [&](casadi_int k, casadi_int t) {
+      if (flag[t]) return;
+      try {
+        flag[t] = eval_k(k, t, mem[t]);
+      } catch (std::exception& e) {
+        flag[t] = 1;
+        error[t] = e.what();
+      }
+    }, n_threads);
+    for (casadi_int t=0; t<n_threads; ++t) release(mem[t]);
+    // Propagate errors
+    for (casadi_int t=0; t<n_threads; ++t) {
+      if (!error[t].empty()) casadi_error(error[t]);
+    }
+    for (casadi_int t=0; t<n_threads; ++t) {
+      if (flag[t]) return 1;
+    }
+    return 0;
+  }
+
 
   void ProtoFunction::print_time(const std::map<std::string, FStats>& fstats) const {
     if (!print_time_) return;
@@ -3533,6 +3898,7 @@ namespace casadi {
 
     s.unpack("ProtoFunction::print_time", print_time_);
     s.unpack("ProtoFunction::record_time", record_time_);
+    init_mem_pool();
   }
 
   void FunctionInternal::serialize_type(SerializingStream &s) const {
@@ -3541,7 +3907,7 @@ namespace casadi {
 
   void FunctionInternal::serialize_body(SerializingStream& s) const {
     ProtoFunction::serialize_body(s);
-    s.version("FunctionInternal", 2);
+    s.version("FunctionInternal", 5);
     s.pack("FunctionInternal::is_diff_in", is_diff_in_);
     s.pack("FunctionInternal::is_diff_out", is_diff_out_);
     s.pack("FunctionInternal::sp_in", sparsity_in_);
@@ -3553,6 +3919,11 @@ namespace casadi {
     s.pack("FunctionInternal::jit_cleanup", jit_cleanup_);
     s.pack("FunctionInternal::jit_serialize", jit_serialize_);
     if (jit_serialize_=="link" || jit_serialize_=="embed") {
+      // The library of a background compilation is available once it has completed
+      if (jit_state_!=JIT_NONE) {
+        casadi_assert(jit_wait(), "Cannot serialize '" + name_ + "' with jit_serialize '"
+          + jit_serialize_ + "': Compilation failed.");
+      }
       s.pack("FunctionInternal::jit_library", compiler_.library());
       if (jit_serialize_=="embed") {
         std::ifstream binary(compiler_.library(), ios_base::binary);
@@ -3563,6 +3934,8 @@ namespace casadi {
     s.pack("FunctionInternal::jit_temp_suffix", jit_temp_suffix_);
     s.pack("FunctionInternal::jit_base_name", jit_base_name_);
     s.pack("FunctionInternal::jit_options", jit_options_);
+    s.pack("FunctionInternal::jit_async", jit_async_);
+    s.pack("FunctionInternal::jit_threshold", jit_threshold_);
     s.pack("FunctionInternal::compiler_plugin", compiler_plugin_);
     s.pack("FunctionInternal::has_refcount", has_refcount_);
 
@@ -3585,6 +3958,7 @@ namespace casadi {
     s.pack("FunctionInternal::never_inline", never_inline_);
 
     s.pack("FunctionInternal::max_num_dir", max_num_dir_);
+    s.pack("FunctionInternal::jac_parallelization", jac_parallelization_);
 
     s.pack("FunctionInternal::regularity_check", regularity_check_);
 
@@ -3614,7 +3988,8 @@ namespace casadi {
   }
 
   FunctionInternal::FunctionInternal(DeserializingStream& s) : ProtoFunction(s) {
-    int version = s.version("FunctionInternal", 1, 2);
+    int version = s.version("FunctionInternal", 1, 5);
+    deserialized_version_ = version;
     s.unpack("FunctionInternal::is_diff_in", is_diff_in_);
     s.unpack("FunctionInternal::is_diff_out", is_diff_out_);
     s.unpack("FunctionInternal::sp_in", sparsity_in_);
@@ -3649,6 +4024,13 @@ namespace casadi {
     s.unpack("FunctionInternal::jit_temp_suffix", jit_temp_suffix_);
     s.unpack("FunctionInternal::jit_base_name", jit_base_name_);
     s.unpack("FunctionInternal::jit_options", jit_options_);
+    if (version>=4) {
+      s.unpack("FunctionInternal::jit_async", jit_async_);
+      s.unpack("FunctionInternal::jit_threshold", jit_threshold_);
+    } else {
+      jit_async_ = false;
+      jit_threshold_ = 0;
+    }
     s.unpack("FunctionInternal::compiler_plugin", compiler_plugin_);
     s.unpack("FunctionInternal::has_refcount", has_refcount_);
 
@@ -3671,6 +4053,11 @@ namespace casadi {
     s.unpack("FunctionInternal::never_inline", never_inline_);
 
     s.unpack("FunctionInternal::max_num_dir", max_num_dir_);
+    if (version>=3) {
+      s.unpack("FunctionInternal::jac_parallelization", jac_parallelization_);
+    } else {
+      jac_parallelization_ = "serial";
+    }
 
     s.unpack("FunctionInternal::regularity_check", regularity_check_);
 
@@ -3707,6 +4094,8 @@ namespace casadi {
     eval_ = nullptr;
     checkout_ = nullptr;
     release_ = nullptr;
+    jit_state_ = JIT_NONE;
+    jit_calls_ = 0;
     jac_sparsity_ = jac_sparsity_compact_ = SparseStorage<Sparsity>(Sparsity(n_out_, n_in_));
 
   }
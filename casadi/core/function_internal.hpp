@@ -27,8 +27,12 @@
 #define CASADI_FUNCTION_INTERNAL_HPP
 
 #include "function.hpp"
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <set>
 #include <stack>
+#include <type_traits>
 #include "code_generator.hpp"
 #include "importer.hpp"
 #include "sparse_storage.hpp"
@@ -38,8 +42,10 @@
 #ifdef CASADI_WITH_THREAD
 #ifdef CASADI_WITH_THREAD_MINGW
 #include <mingw.mutex.h>
+#include <mingw.condition_variable.h>
 #else // CASADI_WITH_THREAD_MINGW
 #include <mutex>
+#include <condition_variable>
 #endif // CASADI_WITH_THREAD_MINGW
 #endif //CASADI_WITH_THREAD
 
@@ -119,12 +125,20 @@ namespace casadi {
     */
     virtual void finalize();
 
-    /// Checkout a memory object
+    /** \brief Checkout a memory object
+        Thread-safe, lock-free unless a new memory object needs to be allocated */
     int checkout() const;
 
-    /// Release a memory object
+    /// Release a memory object (thread-safe, lock-free)
     void release(int mem) const;
 
+    /** \brief Checkout memory object 0, the one reported by stats(), if not claimed yet
+        Any other memory object otherwise, thread-safe */
+    int checkout_first() const;
+
+    /// Release a memory object from checkout_first
+    void release_first(int mem) const;
+
     /// Memory objects
     void* memory(int ind) const;
 
@@ -190,11 +204,40 @@ namespace casadi {
 #endif // CASADI_WITH_THREAD
 
   private:
-    /// Memory objects
-    mutable std::vector<void*> mem_;
+    /// Entry in the pool of memory objects
+    struct MemSlot {
+      // Memory object
+      std::atomic<void*> mem;
+      // Next unused memory object (index+1, 0 if none)
+      std::atomic<std::uint64_t> next;
+    };
+
+    /// Number of blocks in the memory pool, block b holds 8*2^b entries
+    static const casadi_int mem_n_block_ = 32;
+
+    /// Memory objects, stored in blocks that never move when the pool grows
+    mutable std::atomic<MemSlot*> mem_block_[mem_n_block_];
+
+    /// Number of memory objects
+    mutable std::atomic<casadi_int> n_mem_;
+
+    /** \brief Unused memory objects
+     * Lock-free stack: index+1 of the top in the lower 32 bits,
+     * modification counter (against ABA) in the upper 32 bits
+     */
+    mutable std::atomic<std::uint64_t> unused_;
+
+    /// Number of times a checkout/release had to retry due to contention
+    mutable std::atomic<casadi_int> n_mem_contention_;
+
+    /// Memory object 0 has been claimed by checkout_first
+    mutable std::atomic<bool> mem0_claimed_;
+
+    /// Get a memory pool entry
+    MemSlot& mem_slot(casadi_int ind) const;
 
-    /// Unused memory objects
-    mutable std::stack<casadi_int> unused_;
+    /// Initialize the memory pool
+    void init_mem_pool();
   };
 
   /** \brief Internal class for Function
@@ -228,6 +271,18 @@ namespace casadi {
     /** \brief Finalize the object creation */
     void finalize() override;
 
+    /** \brief Generate, compile and load the just-in-time compiled code */
+    void jit_compile();
+
+    /** \brief Start background compilation, if pending */
+    void jit_launch() const;
+
+    /** \brief Status of just-in-time compilation */
+    std::string jit_status() const;
+
+    /** \brief Wait for background compilation, returns true if compiled code is used */
+    bool jit_wait() const;
+
     /** \brief Get a public class instance */
     Function self() const { return shared_from_this<Function>();}
 
@@ -269,6 +324,14 @@ namespace casadi {
     virtual int eval(const double** arg, double** res, casadi_int* iw, double* w, void* mem) const;
     ///@}
 
+    /** \brief Evaluate numerically for n input sets
+        Inputs with batched_in[i] set, as well as all outputs, hold the nonzeros of n
+        evaluations consecutively, other inputs are shared by all evaluations.
+        Work vectors and memory objects are allocated internally.
+        The default implementation loops over the evaluations, optionally on the thread pool. */
+    virtual int eval_batch(const double** arg, double** res, casadi_int n,
+                           const std::vector<bool>& batched_in, bool parallel) const;
+
     /** \brief  Evaluate with symbolic scalars */
     virtual int eval_sx(const SXElem** arg, SXElem** res,
       casadi_int* iw, SXElem* w, void* mem) const;
@@ -451,6 +514,13 @@ namespace casadi {
                                   const Dict& opts) const;
     ///@}
 
+    /** \brief Jacobian with the directional derivative batches evaluated in parallel
+        Used instead of get_jacobian if the option "jac_parallelization" is set */
+    Function get_jacobian_parallel(const std::string& name,
+                                   const std::vector<std::string>& inames,
+                                   const std::vector<std::string>& onames,
+                                   const Dict& opts) const;
+
     ///@{
     /** \brief Return Jacobian of all input elements with respect to all output elements */
     Function jac() const;
@@ -625,6 +695,17 @@ namespace casadi {
     /** \brief Is codegen supported? */
     virtual bool has_codegen() const { return false;}
 
+    /** \brief Work vector length reported by the generated _work function */
+    virtual casadi_int codegen_sz_w(const CodeGenerator& g) const { return sz_w();}
+
+    /** \brief Can a batch entry point be generated? */
+    virtual bool has_codegen_batch() const { return false;}
+
+    /** \brief Generate code for the body of the batch entry point
+        Evaluates n times, nonzero k of evaluation j at arg[i][k*n+j] and res[i][k*n+j],
+        returns 1 if a needed input or output is null */
+    virtual void codegen_batch_body(CodeGenerator& g) const;
+
     /** \brief Jit dependencies */
     virtual void jit_dependencies(const std::string& fname) {}
 
@@ -851,7 +932,8 @@ namespace casadi {
     virtual Dict info() const;
 
     /** \brief Generate/retrieve cached serial map */
-    Function map(casadi_int n, const std::string& parallelization) const;
+    Function map(casadi_int n, const std::string& parallelization,
+                 const Dict& opts=Dict()) const;
 
     /** \brief Export an input file that can be passed to generate C code with a main */
     void generate_in(const std::string& fname, const double** arg) const;
@@ -888,8 +970,27 @@ namespace casadi {
     /** \brief Use a temporary name */
     bool jit_temp_suffix_;
 
-    /** \brief Numerical evaluation redirected to a C function */
-    eval_t eval_;
+    /** \brief Compile in the background, interpret until the compiled code is loaded */
+    bool jit_async_;
+
+    /** \brief Number of calls before background compilation starts */
+    casadi_int jit_threshold_;
+
+    /** \brief State of just-in-time compilation */
+    enum JitState {JIT_NONE, JIT_PENDING, JIT_COMPILING, JIT_READY, JIT_FAILED};
+    mutable std::atomic<int> jit_state_;
+
+    /** \brief Calls while background compilation is pending */
+    mutable std::atomic<casadi_int> jit_calls_;
+
+#ifdef CASADI_WITH_THREAD
+    /** \brief Notify waiting threads when background compilation is done */
+    mutable std::mutex jit_mtx_;
+    mutable std::condition_variable jit_cv_;
+#endif // CASADI_WITH_THREAD
+
+    /** \brief Numerical evaluation redirected to a C function, swapped in when compiled */
+    std::atomic<eval_t> eval_;
 
     /** \brief Checkout redirected to a C function */
     casadi_checkout_t checkout_;
@@ -939,6 +1040,12 @@ namespace casadi {
     /// Maximum number of sensitivity directions
     casadi_int max_num_dir_;
 
+    /// Parallelization of the directional derivative batches of jacobian()
+    std::string jac_parallelization_;
+
+    /// Serialization version of a deserialized object, zero otherwise
+    int deserialized_version_;
+
     /// Errors are thrown when NaN is produced
     bool regularity_check_;
 
@@ -1188,51 +1295,88 @@ namespace casadi {
       return arg;
   }
 
+  /** \brief Work vectors for numerical evaluation via FunctionInternal::call
+      Kept per thread and recursion level and reused between calls, together with
+      a memory object of the last function called, released when the cache is destroyed */
+  template<typename D>
+  struct CallWork {
+    std::vector<const D*> arg;
+    std::vector<D*> res;
+    std::vector<casadi_int> iw;
+    std::vector<D> w;
+    Function f;
+    int mem = -1;
+    ~CallWork() { if (mem>=0) f->release_first(mem);}
+  };
+
   template<typename D>
   void FunctionInternal::
   call_gen(const std::vector<Matrix<D> >& arg, std::vector<Matrix<D> >& res,
            casadi_int npar, bool always_inline, bool never_inline) const {
     casadi_assert(!never_inline, "Call-nodes only possible in MX expressions");
-    std::vector< Matrix<D> > arg2 = project_arg(arg, npar);
 
-    // Which arguments require mapped evaluation
-    std::vector<bool> mapped(n_in_);
+    // Work vectors, cached per thread and recursion level
+    static thread_local std::deque<CallWork<D> > work_stack;
+    static thread_local size_t depth = 0;
+    struct DepthGuard {
+      size_t& d;
+      explicit DepthGuard(size_t& d) : d(d) { d++; }
+      ~DepthGuard() { d--; }
+    } guard(depth);
+    if (work_stack.size()<depth) work_stack.emplace_back();
+    CallWork<D>& work = work_stack[depth-1];
+    work.arg.assign(sz_arg(), nullptr);
+    work.res.assign(sz_res(), nullptr);
+    work.iw.resize(sz_iw());
+    work.w.resize(sz_w());
+
+    // Memory object, checked out once per thread and recursion level
+    if (work.f.get()!=this) {
+      if (work.mem>=0) work.f->release_first(work.mem);
+      work.mem = -1;
+      work.f = self();
+      work.mem = checkout_first();
+    }
+
+    // Get pointers to input arguments, projecting only if sparsity mismatches
+    std::vector< Matrix<D> > arg2;
     for (casadi_int i=0; i<n_in_; ++i) {
-      mapped[i] = arg[i].size2()!=size2_in(i);
+      bool mapped = arg[i].size2()!=size2_in(i);
+      if (mapped ? arg[i].sparsity().is_stacked(sparsity_in(i), npar)
+                 : arg[i].sparsity()==sparsity_in(i)) {
+        work.arg[i] = get_ptr(arg[i]);
+      } else {
+        if (arg2.empty()) arg2.resize(n_in_);
+        arg2[i] = project(arg[i], mapped ? repmat(sparsity_in(i), 1, npar) : sparsity_in(i));
+        work.arg[i] = get_ptr(arg2[i]);
+      }
     }
 
-    // Allocate results
+    // Allocate results, unless already matching
     res.resize(n_out_);
     for (casadi_int i=0; i<n_out_; ++i) {
       if (!res[i].sparsity().is_stacked(sparsity_out(i), npar)) {
         res[i] = Matrix<D>::zeros(repmat(sparsity_out(i), 1, npar));
       }
+      work.res[i] = get_ptr(res[i]);
     }
 
-    // Allocate temporary memory if needed
-    std::vector<casadi_int> iw_tmp(sz_iw());
-    std::vector<D> w_tmp(sz_w());
-
-    // Get pointers to input arguments
-    std::vector<const D*> argp(sz_arg());
-    for (casadi_int i=0; i<n_in_; ++i) argp[i]=get_ptr(arg2[i]);
-
-    // Get pointers to output arguments
-    std::vector<D*> resp(sz_res());
-    for (casadi_int i=0; i<n_out_; ++i) resp[i]=get_ptr(res[i]);
-
     // For all parallel calls
     for (casadi_int p=0; p<npar; ++p) {
-      // Call memory-less
-      if (eval_gen(get_ptr(argp), get_ptr(resp),
-                   get_ptr(iw_tmp), get_ptr(w_tmp), memory(0))) {
+      if (eval_gen(get_ptr(work.arg), get_ptr(work.res),
+                   get_ptr(work.iw), get_ptr(work.w), memory(work.mem))) {
         casadi_error("Evaluation failed");
       }
       // Update offsets
       if (p==npar-1) break;
-      for (casadi_int i=0; i<n_in_; ++i) if (mapped[i]) argp[i] += nnz_in(i);
-      for (casadi_int i=0; i<n_out_; ++i) resp[i] += nnz_out(i);
+      for (casadi_int i=0; i<n_in_; ++i) {
+        if (arg[i].size2()!=size2_in(i)) work.arg[i] += nnz_in(i);
+      }
+      for (casadi_int i=0; i<n_out_; ++i) work.res[i] += nnz_out(i);
     }
+
+    // Do not keep symbolic expressions alive between calls
+    if (!std::is_arithmetic<D>::value) work.w.clear();
   }
 
   template<typename M>
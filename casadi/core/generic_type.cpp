@@ -217,11 +217,13 @@ namespace casadi {
     own(new IntVectorType(iv));
   }
 
+#ifndef CASADI_INT32
   GenericType::GenericType(const vector<int>& iv) {
     std::vector<casadi_int> temp(iv.size());
     std::copy(iv.begin(), iv.end(), temp.begin());
     own(new IntVectorType(temp));
   }
+#endif // CASADI_INT32
 
   GenericType::GenericType(const vector<vector<casadi_int> >& ivv) {
     own(new IntVectorVectorType(ivv));
@@ -377,11 +379,13 @@ namespace casadi {
     return as_int_vector();
   }
 
+#ifndef CASADI_INT32
   GenericType::operator std::vector<int>() const {
     std::vector<int> ret;
     std::vector<casadi_int> source = to_int_vector();
     return casadi::to_int(source);
   }
+#endif // CASADI_INT32
 
   vector<bool> GenericType::to_bool_vector() const {
     casadi_assert(is_int_vector(), "type mismatch");
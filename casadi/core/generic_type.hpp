@@ -79,12 +79,16 @@ namespace casadi {
     /// Constructors (implicit type conversion)
     GenericType(bool b);
     GenericType(casadi_int i);
+#ifndef CASADI_INT32
     GenericType(int i) : GenericType(static_cast<casadi_int>(i)) {}
+#endif // CASADI_INT32
     GenericType(double d);
     GenericType(const std::string& s);
     GenericType(const std::vector<bool>& iv);
     GenericType(const std::vector<casadi_int>& iv);
+#ifndef CASADI_INT32
     GenericType(const std::vector<int>& iv);
+#endif // CASADI_INT32
     GenericType(const std::vector< std::vector<casadi_int> >& ivv);
     GenericType(const std::vector<double>& dv);
     GenericType(const std::vector< std::vector<double> >& dv);
@@ -121,14 +125,20 @@ namespace casadi {
     /// Implicit typecasting
     operator bool() const { return to_bool();}
     operator casadi_int() const { return to_int();}
+#ifndef CASADI_INT32
     operator int() const { return to_int();}
+#endif // CASADI_INT32
     operator double() const { return to_double();}
     operator std::string() const { return to_string();}
     operator std::vector<bool>() const { return to_bool_vector();}
     operator std::vector<casadi_int>() const { return to_int_vector();}
+#ifndef CASADI_INT32
     operator std::vector<int>() const;
+#endif // CASADI_INT32
     operator std::vector<std::vector<casadi_int> >() const { return to_int_vector_vector();}
+#ifndef CASADI_INT32
     operator std::vector<std::vector<int> >() const;
+#endif // CASADI_INT32
     operator std::vector<double>() const { return to_double_vector();}
     operator std::vector< std::vector<double> >() const {
       return to_double_vector_vector();
@@ -36,6 +36,8 @@ namespace casadi {
 
   casadi_int GlobalOptions::max_num_dir = 64;
 
+  casadi_int GlobalOptions::max_num_threads = 0;
+
   // By default, use zero-based indexing
   casadi_int GlobalOptions::start_index = 0;
 
@@ -68,6 +68,12 @@ namespace casadi {
 
       static casadi_int start_index;
 
+      /** \brief Number of threads used for parallel evaluation (e.g. "thread" maps),
+      * including the calling thread. 0 means the hardware concurrency.
+      * Default: 0
+      */
+      static casadi_int max_num_threads;
+
 #endif //SWIG
       // Setter and getter for simplification_on_the_fly
       static void setSimplificationOnTheFly(bool flag) { simplification_on_the_fly = flag; }
@@ -86,6 +92,9 @@ namespace casadi {
       static void setMaxNumDir(casadi_int ndir) { max_num_dir=ndir; }
       static casadi_int getMaxNumDir() { return max_num_dir; }
 
+      static void setMaxNumThreads(casadi_int n) { max_num_threads=n; }
+      static casadi_int getMaxNumThreads() { return max_num_threads; }
+
   };
 
 } // namespace casadi
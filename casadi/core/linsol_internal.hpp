@@ -107,6 +107,9 @@ namespace casadi {
     virtual void generate(CodeGenerator& g, const std::string& A, const std::string& x,
                           casadi_int nrhs, bool tr) const;
 
+    /// Can A and x be given in the type CodeGenerator::solve_real() in generated code?
+    virtual bool has_codegen_mixed() const { return false;}
+
     // Creator function for internal class
     typedef LinsolInternal* (*Creator)(const std::string& name, const Sparsity& sp);
 
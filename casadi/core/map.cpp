@@ -25,35 +25,60 @@
 
 #include "map.hpp"
 #include "serializing_stream.hpp"
+#include <chrono>
 
-#ifdef CASADI_WITH_THREAD
-#ifdef CASADI_WITH_THREAD_MINGW
-#include <mingw.thread.h>
-#else // CASADI_WITH_THREAD_MINGW
-#include <thread>
-#endif // CASADI_WITH_THREAD_MINGW
-#endif // CASADI_WITH_THREAD
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif // WITH_OPENMP
 
 using namespace std;
 
 namespace casadi {
 
-  Function Map::create(const std::string& parallelization, const Function& f, casadi_int n) {
+  Function Map::create(const std::string& parallelization, const Function& f, casadi_int n,
+      const Dict& opts) {
     // Create instance of the right class
     string suffix = str(n) + "_" + f.name();
     if (parallelization == "serial") {
-      return Function::create(new Map("map" + suffix, f, n), Dict());
+      return Function::create(new Map("map" + suffix, f, n), opts);
     } else if (parallelization== "openmp") {
-      return Function::create(new OmpMap("ompmap" + suffix, f, n), Dict());
+      return Function::create(new OmpMap("ompmap" + suffix, f, n), opts);
     } else if (parallelization== "thread") {
-      return Function::create(new ThreadMap("threadmap" + suffix, f, n), Dict());
+      return Function::create(new ThreadMap("threadmap" + suffix, f, n), opts);
+    } else if (parallelization== "process") {
+      return Function::create(new ProcessMap("processmap" + suffix, f, n), opts);
     } else {
       casadi_error("Unknown parallelization: " + parallelization);
     }
   }
 
   Map::Map(const std::string& name, const Function& f, casadi_int n)
-    : FunctionInternal(name), f_(f), n_(n) {
+    : FunctionInternal(name), f_(f), n_(n), n_threads_(1), schedule_(SCHEDULE_STATIC),
+      chunk_size_(0) {
+  }
+
+  const Options Map::options_
+  = {{&FunctionInternal::options_},
+     {{"schedule",
+       {OT_STRING,
+        "Distribution of the iterations among the threads of a parallel map: "
+        "static|dynamic|guided|work_stealing "
+        "[default: dynamic for 'thread', static for 'openmp']"}},
+      {"chunk_size",
+       {OT_INT,
+        "Number of consecutive iterations assigned to a thread at once, "
+        "the minimum for 'guided' [default: automatic]"}}
+     }
+  };
+
+  Dict Map::get_stats(void* mem) const {
+    Dict stats = FunctionInternal::get_stats(mem);
+    auto m = static_cast<MapMemory*>(mem);
+    if (!m->thread_stats.n_iter.empty()) {
+      stats["n_iter_thread"] = m->thread_stats.n_iter;
+      stats["t_wall_thread"] = m->thread_stats.t_wall;
+    }
+    return stats;
   }
 
   bool Map::is_a(const std::string& type, bool recursive) const {
@@ -71,6 +96,11 @@ namespace casadi {
       || (recursive && Map::is_a(type, recursive));
   }
 
+  bool ProcessMap::is_a(const std::string& type, bool recursive) const {
+    return type=="ProcessMap"
+      || (recursive && Map::is_a(type, recursive));
+  }
+
  std::vector<std::string> Map::get_function() const {
     return {"f"};
   }
@@ -97,11 +127,76 @@ namespace casadi {
     s.pack("Map::class_name", class_name());
   }
 
-  Map::Map(DeserializingStream& s) : FunctionInternal(s) {
+  Map::Map(DeserializingStream& s) : FunctionInternal(s), n_threads_(1),
+      schedule_(SCHEDULE_STATIC), chunk_size_(0) {
     s.unpack("Map::f", f_);
     s.unpack("Map::n", n_);
   }
 
+  void OmpMap::serialize_body(SerializingStream &s) const {
+    Map::serialize_body(s);
+    s.version("OmpMap", 2);
+    s.pack("OmpMap::n_threads", n_threads_);
+    s.pack("OmpMap::schedule", to_string(schedule_));
+    s.pack("OmpMap::chunk_size", chunk_size_);
+  }
+
+  OmpMap::OmpMap(DeserializingStream& s) : Map(s) {
+    // No version in streams older than FunctionInternal version 5
+    int version = deserialized_version_>=5 ? s.version("OmpMap", 1, 2) : 1;
+    if (version>=2) {
+      s.unpack("OmpMap::n_threads", n_threads_);
+      std::string schedule;
+      s.unpack("OmpMap::schedule", schedule);
+      schedule_ = to_schedule(schedule);
+      s.unpack("OmpMap::chunk_size", chunk_size_);
+    } else {
+      // Default of init, work vectors were allocated for every iteration
+      n_threads_ = std::min(n_, ThreadPool::size());
+    }
+  }
+
+  void ThreadMap::serialize_body(SerializingStream &s) const {
+    Map::serialize_body(s);
+    s.version("ThreadMap", 2);
+    s.pack("ThreadMap::n_threads", n_threads_);
+    s.pack("ThreadMap::schedule", to_string(schedule_));
+    s.pack("ThreadMap::chunk_size", chunk_size_);
+  }
+
+  ThreadMap::ThreadMap(DeserializingStream& s) : Map(s) {
+    // No version in streams older than FunctionInternal version 5
+    int version = deserialized_version_>=5 ? s.version("ThreadMap", 1, 2) : 1;
+    if (version>=2) {
+      s.unpack("ThreadMap::n_threads", n_threads_);
+      std::string schedule;
+      s.unpack("ThreadMap::schedule", schedule);
+      schedule_ = to_schedule(schedule);
+      s.unpack("ThreadMap::chunk_size", chunk_size_);
+    } else {
+      // Default of init, work vectors were allocated for every iteration
+      n_threads_ = std::min(n_, ThreadPool::size());
+    }
+  }
+
+  void ProcessMap::serialize_body(SerializingStream &s) const {
+    Map::serialize_body(s);
+    s.pack("ProcessMap::n_threads", n_threads_);
+    s.pack("ProcessMap::chunk_size", chunk_size_);
+    s.pack("ProcessMap::off_in", off_in_);
+    s.pack("ProcessMap::off_out", off_out_);
+    s.pack("ProcessMap::sz_buf", sz_buf_);
+  }
+
+  ProcessMap::ProcessMap(DeserializingStream& s) : Map(s), mem_w_(-1) {
+    schedule_ = SCHEDULE_DYNAMIC;
+    s.unpack("ProcessMap::n_threads", n_threads_);
+    s.unpack("ProcessMap::chunk_size", chunk_size_);
+    s.unpack("ProcessMap::off_in", off_in_);
+    s.unpack("ProcessMap::off_out", off_out_);
+    s.unpack("ProcessMap::sz_buf", sz_buf_);
+  }
+
   ProtoFunction* Map::deserialize(DeserializingStream& s) {
     std::string class_name;
     s.unpack("Map::class_name", class_name);
@@ -111,6 +206,8 @@ namespace casadi {
       return new OmpMap(s);
     } else if (class_name=="ThreadMap") {
       return new ThreadMap(s);
+    } else if (class_name=="ProcessMap") {
+      return new ProcessMap(s);
     } else {
       casadi_error("class name '" + class_name + "' unknown.");
     }
@@ -126,6 +223,15 @@ namespace casadi {
     // Call the initialization method of the base class
     FunctionInternal::init(opts);
 
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="schedule") {
+        schedule_ = to_schedule(op.second);
+      } else if (op.first=="chunk_size") {
+        chunk_size_ = op.second;
+      }
+    }
+
     // Allocate sufficient memory for serial evaluation
     alloc_arg(f_.sz_arg());
     alloc_res(f_.sz_res());
@@ -155,6 +261,11 @@ namespace casadi {
     return eval_gen(arg, res, iw, w);
   }
 
+  Sparsity Map::getJacSparsity(casadi_int iind, casadi_int oind, bool symmetric) const {
+    // Block diagonal, one block per iteration
+    return Sparsity::kron(Sparsity::diag(n_), f_.sparsity_jac(iind, oind, true, symmetric));
+  }
+
   int Map::sp_forward(const bvec_t** arg, bvec_t** res,
       casadi_int* iw, bvec_t* w, void* mem) const {
     return eval_gen(arg, res, iw, w);
@@ -181,6 +292,10 @@ namespace casadi {
     g.add_dependency(f_);
   }
 
+  casadi_int Map::codegen_sz_w(const CodeGenerator& g) const {
+    return f_->codegen_sz_w(g);
+  }
+
   void Map::codegen_body(CodeGenerator& g) const {
     g.local("i", "casadi_int");
     g.local("arg1", "const casadi_real*", "*");
@@ -208,6 +323,64 @@ namespace casadi {
     g << "}\n";
   }
 
+  void Map::codegen_body_parallel(CodeGenerator& g) const {
+    size_t sz_arg, sz_res, sz_iw, sz_w;
+    f_.sz_work(sz_arg, sz_res, sz_iw, sz_w);
+    g.add_include("omp.h", false, "_OPENMP");
+    // OpenMP schedule clause, no work stealing in OpenMP
+    casadi_int chunk = chunk_size_>0 ? chunk_size_
+      : ThreadPool::default_chunk(schedule_, n_, n_threads_);
+    std::string schedule = schedule_==SCHEDULE_STATIC ? "static"
+      : schedule_==SCHEDULE_GUIDED ? "guided" : "dynamic";
+    // Memory objects are checked out by each iteration
+    bool needs_mem = !f_->codegen_mem_type().empty();
+    std::string fname = g.add_dependency(f_);
+    g << "casadi_int i;\n"
+      << "int t;\n"
+      << "const casadi_real** arg1;\n"
+      << "casadi_real** res1;\n";
+    if (needs_mem) g << "int mid;\n";
+    g << "casadi_int flag = 0;\n"
+      << "#pragma omp parallel for private(i,t,arg1,res1" << (needs_mem ? ",mid" : "")
+      << ") reduction(||:flag) "
+      << "num_threads(" << n_threads_ << ") schedule(" << schedule << "," << chunk << ")\n"
+      << "for (i=0; i<" << n_ << "; ++i) {\n"
+      << "#ifdef _OPENMP\n"
+      << "t = omp_get_thread_num();\n"
+      << "#else\n"
+      << "t = 0;\n"
+      << "#endif\n"
+      << "arg1 = arg + " << n_in_ << "+t*" << sz_arg << ";\n";
+    for (casadi_int j=0; j<n_in_; ++j) {
+      g << "arg1[" << j << "] = arg[" << j << "] ? "
+        << g.arg(j) << "+i*" << f_.nnz_in(j) << ": 0;\n";
+    }
+    g << "res1 = res + " <<  n_out_ << "+t*" <<  sz_res << ";\n";
+    for (casadi_int j=0; j<n_out_; ++j) {
+      g << "res1[" << j << "] = res[" << j << "] ?"
+        << g.res(j) << "+i*" << f_.nnz_out(j) << ": 0;\n";
+    }
+    std::string call = fname + "(arg1, res1, iw+t*" + str(sz_iw) + ", w+t*"
+      + str(f_->codegen_sz_w(g));
+    if (needs_mem) {
+      // Serialize checkout/release unless they are lock-free
+      std::string critical = "#pragma omp critical(" + fname + "_mem)\n";
+      if (!g.thread_safe) g << critical;
+      g << "mid = " << fname << "_checkout();\n"
+        << "if (mid<0) {\n"
+        << "flag = 1;\n"
+        << "} else {\n"
+        << "flag = " << call << ", mid) || flag;\n";
+      if (!g.thread_safe) g << critical;
+      g << fname << "_release(mid);\n"
+        << "}\n";
+    } else {
+      g << "flag = " << call << ", 0) || flag;\n";
+    }
+    g << "}\n"
+      << "if (flag) return 1;\n";
+  }
+
   Function Map
   ::get_forward(casadi_int nfwd, const std::string& name,
                 const std::vector<std::string>& inames,
@@ -326,42 +499,75 @@ namespace casadi {
 #ifndef WITH_OPENMP
     return Map::eval(arg, res, iw, w, mem);
 #else // WITH_OPENMP
+    auto m = static_cast<MapMemory*>(mem);
     size_t sz_arg, sz_res, sz_iw, sz_w;
     f_.sz_work(sz_arg, sz_res, sz_iw, sz_w);
 
     // Error flag
     casadi_int flag = 0;
 
-    // Checkout memory objects
-    std::vector< scoped_checkout<Function> > ind; ind.reserve(n_);
-    for (casadi_int i=0; i<n_; ++i) ind.emplace_back(f_);
+    // Checkout memory objects, one per thread
+    std::vector< scoped_checkout<Function> > ind; ind.reserve(n_threads_);
+    for (casadi_int t=0; t<n_threads_; ++t) ind.emplace_back(f_);
+
+    // Per-thread statistics
+    ThreadPoolStats& st = m->thread_stats;
+    st.n_iter.assign(n_threads_, 0);
+    st.t_wall.assign(n_threads_, 0);
+
+    // Evaluate iteration i using the buffers of the current thread
+    auto eval_iter = [&](casadi_int i) -> int {
+      casadi_int t = omp_get_thread_num();
+      auto t_start = std::chrono::steady_clock::now();
 
-    // Evaluate in parallel
-#pragma omp parallel for reduction(||:flag)
-    for (casadi_int i=0; i<n_; ++i) {
       // Input buffers
-      const double** arg1 = arg + n_in_ + i*sz_arg;
+      const double** arg1 = arg + n_in_ + t*sz_arg;
       for (casadi_int j=0; j<n_in_; ++j) {
         arg1[j] = arg[j] ? arg[j] + i*f_.nnz_in(j) : 0;
       }
 
       // Output buffers
-      double** res1 = res + n_out_ + i*sz_res;
+      double** res1 = res + n_out_ + t*sz_res;
       for (casadi_int j=0; j<n_out_; ++j) {
         res1[j] = res[j] ? res[j] + i*f_.nnz_out(j) : 0;
       }
 
       // Evaluation
+      int ret;
       try {
-        flag = f_(arg1, res1, iw + i*sz_iw, w + i*sz_w, ind[i]) || flag;
+        ret = f_(arg1, res1, iw + t*sz_iw, w + t*sz_w, ind[t]);
       } catch (std::exception& e) {
-        flag = 1;
+        ret = 1;
         casadi_warning("Exception raised: " + std::string(e.what()));
       } catch (...) {
-        flag = 1;
+        ret = 1;
         casadi_warning("Uncaught exception.");
       }
 
+      // Statistics
+      st.n_iter[t]++;
+      st.t_wall[t] += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t_start).count();
+      return ret;
+    };
+
+    // Evaluate in parallel
+    int nt = static_cast<int>(n_threads_);
+    int chunk = static_cast<int>(chunk_size_>0 ? chunk_size_
+      : ThreadPool::default_chunk(schedule_, n_, n_threads_));
+    switch (schedule_) {
+      case SCHEDULE_STATIC:
+#pragma omp parallel for num_threads(nt) schedule(static, chunk) reduction(||:flag)
+        for (casadi_int i=0; i<n_; ++i) flag = eval_iter(i) || flag;
+        break;
+      case SCHEDULE_GUIDED:
+#pragma omp parallel for num_threads(nt) schedule(guided, chunk) reduction(||:flag)
+        for (casadi_int i=0; i<n_; ++i) flag = eval_iter(i) || flag;
+        break;
+      default:
+        // No work stealing for OpenMP loops
+#pragma omp parallel for num_threads(nt) schedule(dynamic, chunk) reduction(||:flag)
+        for (casadi_int i=0; i<n_; ++i) flag = eval_iter(i) || flag;
     }
 
     // Return error flag
@@ -369,29 +575,12 @@ namespace casadi {
 #endif  // WITH_OPENMP
   }
 
+  casadi_int OmpMap::codegen_sz_w(const CodeGenerator& g) const {
+    return f_->codegen_sz_w(g) * n_threads_;
+  }
+
   void OmpMap::codegen_body(CodeGenerator& g) const {
-    size_t sz_arg, sz_res, sz_iw, sz_w;
-    f_.sz_work(sz_arg, sz_res, sz_iw, sz_w);
-    g << "casadi_int i;\n"
-      << "const double** arg1;\n"
-      << "double** res1;\n"
-      << "casadi_int flag = 0;\n"
-      << "#pragma omp parallel for private(i,arg1,res1) reduction(||:flag)\n"
-      << "for (i=0; i<" << n_ << "; ++i) {\n"
-      << "arg1 = arg + " << n_in_ << "+i*" << sz_arg << ";\n";
-    for (casadi_int j=0; j<n_in_; ++j) {
-      g << "arg1[" << j << "] = arg[" << j << "] ? "
-        << g.arg(j) << "+i*" << f_.nnz_in(j) << ": 0;\n";
-    }
-    g << "res1 = res + " <<  n_out_ << "+i*" <<  sz_res << ";\n";
-    for (casadi_int j=0; j<n_out_; ++j) {
-      g << "res1[" << j << "] = res[" << j << "] ?"
-        << g.res(j) << "+i*" << f_.nnz_out(j) << ": 0;\n";
-    }
-    g << "flag = "
-      << g(f_, "arg1", "res1", "iw+i*" + str(sz_iw), "w+i*" + str(sz_w)) << " || flag;\n"
-      << "}\n"
-      << "if (flag) return 1;\n";
+    codegen_body_parallel(g);
   }
 
   void OmpMap::init(const Dict& opts) {
@@ -402,14 +591,14 @@ namespace casadi {
     // Call the initialization method of the base class
     Map::init(opts);
 
-    // Allocate memory for holding memory object references
-    alloc_iw(n_, true);
+    // Number of threads
+    n_threads_ = std::min(n_, ThreadPool::size());
 
     // Allocate sufficient memory for parallel evaluation
-    alloc_arg(f_.sz_arg() * n_);
-    alloc_res(f_.sz_res() * n_);
-    alloc_w(f_.sz_w() * n_);
-    alloc_iw(f_.sz_iw() * n_);
+    alloc_arg(f_.sz_arg() * n_threads_);
+    alloc_res(f_.sz_res() * n_threads_);
+    alloc_w(f_.sz_w() * n_threads_);
+    alloc_iw(f_.sz_iw() * n_threads_);
   }
 
 
@@ -417,7 +606,7 @@ namespace casadi {
     clear_mem();
   }
 
-  void ThreadsWork(const Function& f, casadi_int i,
+  void ThreadsWork(const Function& f, casadi_int i, casadi_int t,
       const double** arg, double** res,
       casadi_int* iw, double* w,
       casadi_int ind, int& ret) {
@@ -430,20 +619,20 @@ namespace casadi {
     size_t sz_arg, sz_res, sz_iw, sz_w;
     f.sz_work(sz_arg, sz_res, sz_iw, sz_w);
 
-    // Input buffers
-    const double** arg1 = arg + n_in + i*sz_arg;
+    // Input buffers, owned by thread t
+    const double** arg1 = arg + n_in + t*sz_arg;
     for (casadi_int j=0; j<n_in; ++j) {
       arg1[j] = arg[j] ? arg[j] + i*f.nnz_in(j) : nullptr;
     }
 
-    // Output buffers
-    double** res1 = res + n_out + i*sz_res;
+    // Output buffers, owned by thread t
+    double** res1 = res + n_out + t*sz_res;
     for (casadi_int j=0; j<n_out; ++j) {
       res1[j] = res[j] ? res[j] + i*f.nnz_out(j) : nullptr;
     }
 
     try {
-      ret = f(arg1, res1, iw + i*sz_iw, w + i*sz_w, ind);
+      if (f(arg1, res1, iw + t*sz_iw, w + t*sz_w, ind)) ret = 1;
     } catch (std::exception& e) {
       ret = 1;
       casadi_warning("Exception raised: " + std::string(e.what()));
@@ -459,29 +648,18 @@ namespace casadi {
 #ifndef CASADI_WITH_THREAD
     return Map::eval(arg, res, iw, w, mem);
 #else // CASADI_WITH_THREAD
-    // Checkout memory objects
-    std::vector< scoped_checkout<Function> > ind; ind.reserve(n_);
-    for (casadi_int i=0; i<n_; ++i) ind.emplace_back(f_);
-
-    // Allocate space for return values
-    std::vector<int> ret_values(n_);
+    // Checkout memory objects, one per thread
+    std::vector< scoped_checkout<Function> > ind; ind.reserve(n_threads_);
+    for (casadi_int t=0; t<n_threads_; ++t) ind.emplace_back(f_);
 
-    // Spawn threads
-    std::vector<std::thread> threads;
-    for (casadi_int i=0; i<n_; ++i) {
-      // Why the lambda function?
-      // Because it was the first iteration to pass tests on MingGW
-      // using mingw-std-threads.
-      threads.emplace_back(
-        [i](const Function& f, const double** arg, double** res,
-            casadi_int* iw, double* w, casadi_int ind, int& ret) {
-              ThreadsWork(f, i, arg, res, iw, w, ind, ret);
-            },
-        std::ref(f_), arg, res, iw, w, casadi_int(ind[i]), std::ref(ret_values[i]));
-    }
+    // Return values, per thread
+    std::vector<int> ret_values(n_threads_, 0);
 
-    // Join threads
-    for (auto && th : threads) th.join();
+    // Evaluate using the persistent thread pool
+    auto m = static_cast<MapMemory*>(mem);
+    ThreadPool::instance().run(n_, chunk_size_, [&](casadi_int i, casadi_int t) {
+      ThreadsWork(f_, i, t, arg, res, iw, w, ind[t], ret_values[t]);
+    }, n_threads_, schedule_, &m->thread_stats);
 
     // Anticipate success
     int ret = 0;
@@ -493,8 +671,12 @@ namespace casadi {
 #endif // CASADI_WITH_THREAD
   }
 
+  casadi_int ThreadMap::codegen_sz_w(const CodeGenerator& g) const {
+    return f_->codegen_sz_w(g) * n_threads_;
+  }
+
   void ThreadMap::codegen_body(CodeGenerator& g) const {
-    Map::codegen_body(g);
+    codegen_body_parallel(g);
   }
 
   void ThreadMap::init(const Dict& opts) {
@@ -505,14 +687,98 @@ namespace casadi {
     // Call the initialization method of the base class
     Map::init(opts);
 
-    // Allocate memory for holding memory object references
-    alloc_iw(n_, true);
+    // Number of threads
+    n_threads_ = std::min(n_, ThreadPool::size());
 
     // Allocate sufficient memory for parallel evaluation
-    alloc_arg(f_.sz_arg() * n_);
-    alloc_res(f_.sz_res() * n_);
-    alloc_w(f_.sz_w() * n_);
-    alloc_iw(f_.sz_iw() * n_);
+    alloc_arg(f_.sz_arg() * n_threads_);
+    alloc_res(f_.sz_res() * n_threads_);
+    alloc_w(f_.sz_w() * n_threads_);
+    alloc_iw(f_.sz_iw() * n_threads_);
+  }
+
+  ProcessMap::~ProcessMap() {
+    // Terminate the workers before the function goes out of scope
+    pool_.reset();
+    clear_mem();
+  }
+
+  void ProcessMap::init(const Dict& opts) {
+    if (!ProcessPool::available()) {
+      casadi_warning("Process-based parallelization not supported on this platform. "
+                     "Falling back to serial evaluation.");
+    }
+    // Call the initialization method of the base class
+    Map::init(opts);
+
+    // Number of worker processes
+    n_threads_ = std::min(n_, ProcessPool::default_size());
+
+    // Shared buffer: presence flags, then all inputs and outputs
+    sz_buf_ = n_in_ + n_out_;
+    off_in_.resize(n_in_);
+    for (casadi_int j=0; j<n_in_; ++j) {
+      off_in_[j] = sz_buf_;
+      sz_buf_ += n_*f_.nnz_in(j);
+    }
+    off_out_.resize(n_out_);
+    for (casadi_int j=0; j<n_out_; ++j) {
+      off_out_[j] = sz_buf_;
+      sz_buf_ += n_*f_.nnz_out(j);
+    }
+  }
+
+  int ProcessMap::eval_worker(casadi_int i, double* buf) const {
+    // Memory object, checked out in the worker process
+    if (mem_w_<0) mem_w_ = f_.checkout();
+    // Input buffers
+    for (casadi_int j=0; j<n_in_; ++j) {
+      arg_w_[j] = buf[j] ? buf + off_in_[j] + i*f_.nnz_in(j) : nullptr;
+    }
+    // Output buffers
+    for (casadi_int j=0; j<n_out_; ++j) {
+      res_w_[j] = buf[n_in_+j] ?
+        buf + off_out_[j] + i*f_.nnz_out(j) : nullptr;
+    }
+    return f_(get_ptr(arg_w_), get_ptr(res_w_), get_ptr(iw_w_), get_ptr(w_w_), mem_w_);
+  }
+
+  int ProcessMap::eval(const double** arg, double** res, casadi_int* iw, double* w,
+      void* mem) const {
+    if (!ProcessPool::available() || n_threads_<=1) return Map::eval(arg, res, iw, w, mem);
+#ifdef CASADI_WITH_THREAD
+    std::lock_guard<std::mutex> lock(pool_mtx_);
+#endif // CASADI_WITH_THREAD
+
+    // Start the workers, or restart them after a failure
+    if (!pool_ || pool_->broken()) {
+      pool_.reset();
+      // Work vectors, copied into each worker
+      arg_w_.resize(f_.sz_arg());
+      res_w_.resize(f_.sz_res());
+      iw_w_.resize(f_.sz_iw());
+      w_w_.resize(f_.sz_w());
+      mem_w_ = -1;
+      pool_.reset(new ProcessPool(n_threads_, sz_buf_*sizeof(double),
+        [this](casadi_int i, void* buf) { return eval_worker(i, static_cast<double*>(buf)); }));
+    }
+
+    // Pass inputs
+    double* buf = static_cast<double*>(pool_->buffer());
+    for (casadi_int j=0; j<n_in_; ++j) {
+      buf[j] = arg[j] ? 1 : 0;
+      if (arg[j]) casadi_copy(arg[j], n_*f_.nnz_in(j), buf + off_in_[j]);
+    }
+    for (casadi_int j=0; j<n_out_; ++j) buf[n_in_+j] = res[j] ? 1 : 0;
+
+    // Evaluate in the workers
+    int ret = pool_->run(n_, chunk_size_);
+
+    // Get outputs
+    for (casadi_int j=0; j<n_out_; ++j) {
+      if (res[j]) casadi_copy(buf + off_out_[j], n_*f_.nnz_out(j), res[j]);
+    }
+    return ret;
   }
 
 } // namespace casadi
@@ -27,11 +27,19 @@
 #define CASADI_MAP_HPP
 
 #include "function_internal.hpp"
+#include "thread_pool.hpp"
+#include "process_pool.hpp"
 
 /// \cond INTERNAL
 
 namespace casadi {
 
+  /** \brief Memory for Map */
+  struct CASADI_EXPORT MapMemory : public FunctionMemory {
+    // Per-thread statistics of the last evaluation (parallel maps)
+    ThreadPoolStats thread_stats;
+  };
+
   /** Evaluate in parallel
       \author Joel Andersson
       \date 2015
@@ -40,7 +48,7 @@ namespace casadi {
   public:
     // Create function (use instead of constructor)
     static Function create(const std::string& parallelization,
-                           const Function& f, casadi_int n);
+                           const Function& f, casadi_int n, const Dict& opts=Dict());
 
     /** \brief Destructor */
     ~Map() override;
@@ -51,6 +59,21 @@ namespace casadi {
     /** \brief Check if the function is of a particular type */
     bool is_a(const std::string& type, bool recursive) const override;
 
+    ///@{
+    /** \brief Options */
+    static const Options options_;
+    const Options& get_options() const override { return options_;}
+    ///@}
+
+    /** \brief Create memory block */
+    void* alloc_mem() const override { return new MapMemory();}
+
+    /** \brief Free memory block */
+    void free_mem(void *mem) const override { delete static_cast<MapMemory*>(mem);}
+
+    /// Get all statistics
+    Dict get_stats(void* mem) const override;
+
     // Get list of dependency functions
     virtual std::vector<std::string> get_function() const override;
 
@@ -112,6 +135,9 @@ namespace casadi {
     bool has_sprev() const override { return true;}
     ///@}
 
+    /// Generate the sparsity of a Jacobian block from that of the base function
+    Sparsity getJacSparsity(casadi_int iind, casadi_int oind, bool symmetric) const override;
+
     /** \brief Is codegen supported? */
     bool has_codegen() const override { return true;}
 
@@ -121,6 +147,13 @@ namespace casadi {
     /** \brief Generate code for the body of the C function */
     void codegen_body(CodeGenerator& g) const override;
 
+    /** \brief Work vector length reported by the generated _work function */
+    casadi_int codegen_sz_w(const CodeGenerator& g) const override;
+
+    /** \brief Generate an OpenMP loop over the iterations, one set of work vectors per thread
+        Compiles to a serial loop without OpenMP */
+    void codegen_body_parallel(CodeGenerator& g) const;
+
     /** \brief  Initialize */
     void init(const Dict& opts) override;
 
@@ -168,11 +201,20 @@ namespace casadi {
 
     // Number of times to evaluate this function
     casadi_int n_;
+
+    // Number of threads, each with its own work vectors and memory object
+    casadi_int n_threads_;
+
+    // Distribution of iterations among threads
+    ThreadSchedule schedule_;
+
+    // Number of consecutive iterations assigned at once, 0 for automatic
+    casadi_int chunk_size_;
   };
 
   /** A map Evaluate in parallel using OpenMP
-      Note: Do not use this class with much more than the intended number of
-      threads for the parallel evaluation as it will cause excessive memory use.
+      Each thread reuses one set of work vectors, so memory use does not grow
+      with the map count. The "work_stealing" schedule falls back to "dynamic".
 
       \author Joel Andersson
       \date 2015
@@ -204,14 +246,21 @@ namespace casadi {
     /** \brief Generate code for the body of the C function */
     void codegen_body(CodeGenerator& g) const override;
 
+    /** \brief Work vector length reported by the generated _work function */
+    casadi_int codegen_sz_w(const CodeGenerator& g) const override;
+
+    /** \brief Serialize an object without type information */
+    void serialize_body(SerializingStream &s) const override;
+
   protected:
     /** \brief Deserializing constructor */
-    explicit OmpMap(DeserializingStream& s) : Map(s) {}
+    explicit OmpMap(DeserializingStream& s);
   };
 
-  /** A map Evaluate in parallel using std::thread
-      Note: Do not use this class with much more than the intended number of
-      threads for the parallel evaluation as it will cause excessive memory use.
+  /** A map Evaluate in parallel using the persistent ThreadPool
+      The number of threads is set by GlobalOptions::max_num_threads at construction.
+      Work vectors and memory objects are allocated per thread, not per iteration.
+      Generated code uses an OpenMP loop with the same thread count and schedule.
 
       \author Joris Gillis
       \date 2018
@@ -220,7 +269,9 @@ namespace casadi {
     friend class Map;
   public:
     // Constructor (protected, use create function in Map)
-    ThreadMap(const std::string& name, const Function& f, casadi_int n) : Map(name, f, n) {}
+    ThreadMap(const std::string& name, const Function& f, casadi_int n) : Map(name, f, n) {
+      schedule_ = SCHEDULE_DYNAMIC;
+    }
 
     /** \brief  Destructor */
     ~ThreadMap() override;
@@ -243,9 +294,82 @@ namespace casadi {
     /** \brief Generate code for the body of the C function */
     void codegen_body(CodeGenerator& g) const override;
 
+    /** \brief Work vector length reported by the generated _work function */
+    casadi_int codegen_sz_w(const CodeGenerator& g) const override;
+
+    /** \brief Serialize an object without type information */
+    void serialize_body(SerializingStream &s) const override;
+
   protected:
     /** \brief Deserializing constructor */
-    explicit ThreadMap(DeserializingStream& s) : Map(s) {}
+    explicit ThreadMap(DeserializingStream& s);
+  };
+
+  /** A map Evaluate in parallel using forked worker processes
+      Intended for functions that are not thread-safe, e.g. callbacks or external
+      libraries with global state. The workers are forked at the first evaluation
+      and keep a copy of the function as it was at that point. Inputs and outputs
+      are exchanged through shared memory and iterations are handed out
+      dynamically in chunks of "chunk_size". The number of workers is set by
+      GlobalOptions::max_num_threads at construction. POSIX only.
+  */
+  class CASADI_EXPORT ProcessMap : public Map {
+    friend class Map;
+  public:
+    // Constructor (protected, use create function in Map)
+    ProcessMap(const std::string& name, const Function& f, casadi_int n)
+        : Map(name, f, n), sz_buf_(0), mem_w_(-1) {
+      schedule_ = SCHEDULE_DYNAMIC;
+    }
+
+    /** \brief  Destructor */
+    ~ProcessMap() override;
+
+    /** \brief Get type name */
+    std::string class_name() const override {return "ProcessMap";}
+
+    /** \brief Check if the function is of a particular type */
+    bool is_a(const std::string& type, bool recursive) const override;
+
+    /// Evaluate the function numerically
+    int eval(const double** arg, double** res, casadi_int* iw, double* w, void* mem) const override;
+
+    /** \brief  Initialize */
+    void init(const Dict& opts) override;
+
+    /// Type of parallellization
+    std::string parallelization() const override { return "process"; }
+
+    /** \brief Serialize an object without type information */
+    void serialize_body(SerializingStream &s) const override;
+
+  protected:
+    /** \brief Deserializing constructor */
+    explicit ProcessMap(DeserializingStream& s);
+
+    // Evaluate iteration i in a worker process, given the shared buffer
+    int eval_worker(casadi_int i, double* buf) const;
+
+    // Offsets of the inputs and outputs in the shared buffer
+    std::vector<casadi_int> off_in_, off_out_;
+
+    // Size of the shared buffer, in doubles
+    casadi_int sz_buf_;
+
+    // Worker processes, started at the first evaluation
+    mutable std::unique_ptr<ProcessPool> pool_;
+
+    // Work vectors used by the workers
+    mutable std::vector<const double*> arg_w_;
+    mutable std::vector<double*> res_w_;
+    mutable std::vector<casadi_int> iw_w_;
+    mutable std::vector<double> w_w_;
+    mutable int mem_w_;
+
+#ifdef CASADI_WITH_THREAD
+    // Serializes evaluations, which share the pool
+    mutable std::mutex pool_mtx_;
+#endif // CASADI_WITH_THREAD
   };
 
 } // namespace casadi
@@ -51,6 +51,8 @@ namespace casadi {
         f->tocache(ret, suffix);
       }
       return ret.wrap_as_needed(opts);
+    } else if (parallelization == "thread") {
+      return Function::create(new ThreadMapSum(name, f, n, reduce_in, reduce_out), opts);
     } else {
       casadi_error("Unknown parallelization: " + parallelization);
     }
@@ -89,6 +91,8 @@ namespace casadi {
     s.unpack("MapSum::class_name", class_name);
     if (class_name=="MapSum") {
       return new MapSum(s);
+    } else if (class_name=="ThreadMapSum") {
+      return new ThreadMapSum(s);
     } else {
       casadi_error("class name '" + class_name + "' unknown.");
     }
@@ -170,6 +174,27 @@ namespace casadi {
     return eval_gen(arg, res, iw, w);
   }
 
+  Sparsity MapSum::getJacSparsity(casadi_int iind, casadi_int oind, bool symmetric) const {
+    // Symmetry is only preserved if the block is block diagonal or not repeated
+    if (symmetric && reduce_in_[iind]!=reduce_out_[oind]) {
+      return FunctionInternal::getJacSparsity(iind, oind, symmetric);
+    }
+    Sparsity sp = f_.sparsity_jac(iind, oind, true, symmetric);
+    if (reduce_in_[iind] && reduce_out_[oind]) {
+      // Union of identical patterns
+      return sp;
+    } else if (reduce_in_[iind]) {
+      // Shared input: one block row per iteration
+      return Sparsity::kron(Sparsity::dense(n_, 1), sp);
+    } else if (reduce_out_[oind]) {
+      // Summed output: one block column per iteration
+      return Sparsity::kron(Sparsity::dense(1, n_), sp);
+    } else {
+      // Block diagonal, one block per iteration
+      return Sparsity::kron(Sparsity::diag(n_), sp);
+    }
+  }
+
   int MapSum::sp_forward(const bvec_t** arg, bvec_t** res,
       casadi_int* iw, bvec_t* w, void* mem) const {
     return eval_gen(arg, res, iw, w);
@@ -399,4 +424,132 @@ namespace casadi {
     return eval_gen(arg, res, iw, w, m);
   }
 
+  const casadi_int ThreadMapSum::max_blocks;
+
+  ThreadMapSum::ThreadMapSum(const std::string& name, const Function& f, casadi_int n,
+                             const std::vector<bool>& reduce_in,
+                             const std::vector<bool>& reduce_out)
+    : MapSum(name, f, n, reduce_in, reduce_out),
+      n_threads_(1), block_size_(1), n_blocks_(0), nnz_reduce_(0) {
+  }
+
+  ThreadMapSum::~ThreadMapSum() {
+    clear_mem();
+  }
+
+  void ThreadMapSum::serialize_body(SerializingStream &s) const {
+    MapSum::serialize_body(s);
+    s.pack("ThreadMapSum::n_threads", n_threads_);
+    s.pack("ThreadMapSum::block_size", block_size_);
+    s.pack("ThreadMapSum::n_blocks", n_blocks_);
+    s.pack("ThreadMapSum::nnz_reduce", nnz_reduce_);
+  }
+
+  ThreadMapSum::ThreadMapSum(DeserializingStream& s) : MapSum(s) {
+    s.unpack("ThreadMapSum::n_threads", n_threads_);
+    s.unpack("ThreadMapSum::block_size", block_size_);
+    s.unpack("ThreadMapSum::n_blocks", n_blocks_);
+    s.unpack("ThreadMapSum::nnz_reduce", nnz_reduce_);
+  }
+
+  void ThreadMapSum::init(const Dict& opts) {
+    // Call the initialization method of the base class
+    MapSum::init(opts);
+
+    // Blocks of consecutive iterations, independent of the number of threads
+    n_blocks_ = std::min(n_, max_blocks);
+    block_size_ = n_blocks_ ? (n_ + n_blocks_ - 1)/n_blocks_ : 1;
+    n_blocks_ = (n_ + block_size_ - 1)/block_size_;
+
+    // Number of threads
+    n_threads_ = std::max(std::min(n_blocks_, ThreadPool::size()), casadi_int(1));
+
+    // Total size of the reduced outputs
+    nnz_reduce_ = 0;
+    for (casadi_int j=0; j<n_out_; ++j) {
+      if (reduce_out_[j]) nnz_reduce_ += f_.nnz_out(j);
+    }
+
+    // Work vectors and scratch space per thread, one accumulator per block
+    alloc_arg(f_.sz_arg() * n_threads_);
+    alloc_res(f_.sz_res() * n_threads_);
+    alloc_iw(f_.sz_iw() * n_threads_);
+    alloc_w((f_.sz_w() + nnz_reduce_) * n_threads_ + nnz_reduce_ * n_blocks_);
+  }
+
+  int ThreadMapSum::eval(const double** arg, double** res, casadi_int* iw, double* w,
+      void* mem) const {
+    if (n_blocks_==0) return MapSum::eval(arg, res, iw, w, mem);
+    size_t sz_arg, sz_res, sz_iw, sz_w;
+    f_.sz_work(sz_arg, sz_res, sz_iw, sz_w);
+
+    // Accumulators of the reduced outputs, one per block
+    double* acc = w + (sz_w + nnz_reduce_) * n_threads_;
+    casadi_clear(acc, nnz_reduce_ * n_blocks_);
+
+    // Checkout memory objects, one per thread
+    std::vector< scoped_checkout<Function> > ind; ind.reserve(n_threads_);
+    for (casadi_int t=0; t<n_threads_; ++t) ind.emplace_back(f_);
+
+    // Return values, per thread
+    std::vector<int> ret_values(n_threads_, 0);
+
+    // Evaluate the blocks in parallel
+    ThreadPool::instance().run(n_blocks_, 1, [&](casadi_int b, casadi_int t) {
+      const double** arg1 = arg + n_in_ + t*sz_arg;
+      double** res1 = res + n_out_ + t*sz_res;
+      double* w1 = w + t*(sz_w + nnz_reduce_);
+      casadi_int i0 = b*block_size_, i1 = std::min(i0 + block_size_, n_);
+      for (casadi_int j=0; j<n_in_; ++j) {
+        arg1[j] = arg[j] && !reduce_in_[j] ? arg[j] + i0*f_.nnz_in(j) : arg[j];
+      }
+      for (casadi_int i=i0; i<i1; ++i) {
+        // Reduced outputs to scratch space, others in place
+        double* scratch = w1 + sz_w;
+        for (casadi_int j=0; j<n_out_; ++j) {
+          if (reduce_out_[j]) {
+            res1[j] = res[j] ? scratch : nullptr;
+            scratch += f_.nnz_out(j);
+          } else {
+            res1[j] = res[j] ? res[j] + i*f_.nnz_out(j) : nullptr;
+          }
+        }
+        try {
+          if (f_(arg1, res1, iw + t*sz_iw, w1, ind[t])) ret_values[t] = 1;
+        } catch (std::exception& e) {
+          ret_values[t] = 1;
+          casadi_warning("Exception raised: " + std::string(e.what()));
+        } catch (...) {
+          ret_values[t] = 1;
+          casadi_warning("Uncaught exception.");
+        }
+        // Sum into the accumulator of the block
+        casadi_add(nnz_reduce_, w1 + sz_w, acc + b*nnz_reduce_);
+        for (casadi_int j=0; j<n_in_; ++j) {
+          if (arg1[j] && !reduce_in_[j]) arg1[j] += f_.nnz_in(j);
+        }
+      }
+    }, n_threads_);
+
+    // Combine the block sums in a fixed pairwise tree
+    for (casadi_int s=1; s<n_blocks_; s*=2) {
+      for (casadi_int b=0; b+s<n_blocks_; b+=2*s) {
+        casadi_add(nnz_reduce_, acc + (b+s)*nnz_reduce_, acc + b*nnz_reduce_);
+      }
+    }
+
+    // Get the reduced outputs
+    for (casadi_int j=0; j<n_out_; ++j) {
+      if (reduce_out_[j]) {
+        casadi_copy(acc, f_.nnz_out(j), res[j]);
+        acc += f_.nnz_out(j);
+      }
+    }
+
+    // Aggregate return value
+    int ret = 0;
+    for (int e : ret_values) ret = ret || e;
+    return ret;
+  }
+
 } // namespace casadi
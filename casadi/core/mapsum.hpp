@@ -27,6 +27,7 @@
 #define CASADI_MAPSUM_HPP
 
 #include "function_internal.hpp"
+#include "thread_pool.hpp"
 
 /// \cond INTERNAL
 
@@ -113,6 +114,9 @@ namespace casadi {
     bool has_sprev() const override { return true;}
     ///@}
 
+    /// Generate the sparsity of a Jacobian block from that of the base function
+    Sparsity getJacSparsity(casadi_int iind, casadi_int oind, bool symmetric) const override;
+
     /** \brief Is codegen supported? */
     bool has_codegen() const override { return true;}
 
@@ -179,6 +183,52 @@ namespace casadi {
   };
 
 
+  /** MapSum evaluated in parallel using the persistent ThreadPool
+      The iterations are split into at most max_blocks contiguous blocks, independent
+      of the number of threads. Each block sums its iterations in order into its own
+      accumulator, and the accumulators are combined with a fixed pairwise tree.
+      The result is therefore reproducible bit-for-bit for any thread count.
+  */
+  class CASADI_EXPORT ThreadMapSum : public MapSum {
+    friend class MapSum;
+  public:
+    /** \brief Destructor */
+    ~ThreadMapSum() override;
+
+    /** \brief Get type name */
+    std::string class_name() const override {return "ThreadMapSum";}
+
+    /// Evaluate the function numerically
+    int eval(const double** arg, double** res, casadi_int* iw, double* w, void* mem) const override;
+
+    /// Type of parallellization
+    std::string parallelization() const override { return "thread"; }
+
+    /** \brief  Initialize */
+    void init(const Dict& opts) override;
+
+    /** \brief Serialize an object without type information */
+    void serialize_body(SerializingStream &s) const override;
+
+    /// Maximum number of blocks
+    static const casadi_int max_blocks = 64;
+
+  protected:
+    // Constructor (protected, use create function in MapSum)
+    ThreadMapSum(const std::string& name, const Function& f, casadi_int n,
+           const std::vector<bool>& reduce_in,
+           const std::vector<bool>& reduce_out);
+
+    /** \brief Deserializing constructor */
+    explicit ThreadMapSum(DeserializingStream& s);
+
+    // Number of threads, block size, number of blocks
+    casadi_int n_threads_, block_size_, n_blocks_;
+
+    // Total number of nonzeros of the reduced outputs
+    casadi_int nnz_reduce_;
+  };
+
 } // namespace casadi
 /// \endcond
 
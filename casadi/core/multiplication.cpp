@@ -132,6 +132,24 @@ namespace casadi {
     }
 
     casadi_int nrow_x = dep(1).size1(), nrow_y = dep(2).size1(), ncol_y = dep(2).size2();
+
+    // Large products: call CBLAS when available, fall back to the loop otherwise
+    bool blas = g.use_cblas(nrow_x*nrow_y*ncol_y);
+    if (blas) {
+      g << "#ifdef CASADI_WITH_CBLAS\n";
+      if (ncol_y==1) {
+        g << "cblas_dgemv(CblasColMajor, CblasNoTrans, " << nrow_x << ", " << nrow_y << ", 1., "
+          << g.work(arg[1], dep(1).nnz()) << ", " << nrow_x << ", "
+          << g.work(arg[2], dep(2).nnz()) << ", 1, 1., " << g.work(res[0], nnz()) << ", 1);\n";
+      } else {
+        g << "cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, "
+          << nrow_x << ", " << ncol_y << ", " << nrow_y << ", 1., "
+          << g.work(arg[1], dep(1).nnz()) << ", " << nrow_x << ", "
+          << g.work(arg[2], dep(2).nnz()) << ", " << nrow_y << ", 1., "
+          << g.work(res[0], nnz()) << ", " << nrow_x << ");\n";
+      }
+      g << "#else\n";
+    }
     g.local("rr", "casadi_real", "*");
     g.local("ss", "casadi_real", "*");
     g.local("tt", "casadi_real", "*");
@@ -143,6 +161,7 @@ namespace casadi {
       << " for (k=0, ss=" << g.work(arg[1], dep(1).nnz()) << "+j, tt="
       << g.work(arg[2], dep(2).nnz()) << "+i*" << nrow_y << "; k<" << nrow_y << "; ++k)"
       << " *rr += ss[k*" << nrow_x << "]**tt++;\n";
+    if (blas) g << "#endif\n";
   }
 
   void Multiplication::serialize_type(SerializingStream& s) const {
@@ -1672,7 +1672,13 @@ namespace casadi {
   MX MX::hessian(const MX& f, const MX& x, MX &g, const Dict& opts) {
     try {
       Dict all_opts = opts;
-      g = gradient(f, x, opts);
+      auto it = all_opts.find("hessian_method");
+      if (it!=all_opts.end()) {
+        casadi_assert(it->second.to_string()=="coloring",
+          "Hessian method '" + it->second.to_string() + "' only available for SX");
+        all_opts.erase(it);
+      }
+      g = gradient(f, x, all_opts);
       if (!opts.count("symmetric")) all_opts["symmetric"] = true;
       return jacobian(g, x, all_opts);
     } catch (std::exception& e) {
@@ -1114,7 +1114,30 @@ namespace casadi {
     }
   }
 
+  size_t MXFunction::codegen_sz_w_tmp(const CodeGenerator& g) const {
+    // Temporary work in front of the work vector elements, cf. init
+    size_t sz_tmp = 0, sz_tmp_gen = 0;
+    for (auto&& e : algorithm_) {
+      if (e.op==OP_OUTPUT) continue;
+      for (casadi_int c : e.res) {
+        if (c>=0) {
+          sz_tmp = std::max(sz_tmp, e.data->sz_w());
+          sz_tmp_gen = std::max(sz_tmp_gen, e.data->codegen_sz_w(g));
+          break;
+        }
+      }
+    }
+    return sz_tmp_gen>sz_tmp ? sz_tmp_gen-sz_tmp : 0;
+  }
+
+  casadi_int MXFunction::codegen_sz_w(const CodeGenerator& g) const {
+    return sz_w() + codegen_sz_w_tmp(g);
+  }
+
   void MXFunction::codegen_body(CodeGenerator& g) const {
+    // Work vector elements follow the temporary work of the operations
+    size_t w_offset = codegen_sz_w_tmp(g);
+
     // Temporary variables and vectors
     g.init_local("arg1", "arg+" + str(n_in_));
     g.init_local("res1", "res+" + str(n_out_));
@@ -1140,7 +1163,7 @@ namespace casadi {
       if (!g.codegen_scalars && n==1) {
         g << "w" << i;
       } else {
-        g << "*w" << i << "=w+" << workloc_[i];
+        g << "*w" << i << "=w+" << workloc_[i] + w_offset;
       }
     }
     if (!first) g << ";\n";
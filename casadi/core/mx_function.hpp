@@ -128,6 +128,12 @@ namespace casadi {
     /** \brief Generate code for the body of the C function */
     void codegen_body(CodeGenerator& g) const override;
 
+    /** \brief Work vector length reported by the generated _work function */
+    casadi_int codegen_sz_w(const CodeGenerator& g) const override;
+
+    /** \brief Additional temporary work of the operations in generated code */
+    size_t codegen_sz_w_tmp(const CodeGenerator& g) const;
+
     /** \brief Serialize an object without type information */
     void serialize_body(SerializingStream &s) const override;
 
@@ -258,6 +258,9 @@ namespace casadi {
     /** \brief Get required length of w field */
     virtual size_t sz_w() const { return 0;}
 
+    /** \brief Get required length of w field in generated code */
+    virtual size_t codegen_sz_w(const CodeGenerator& g) const { return sz_w();}
+
     /// Set unary dependency
     void set_dep(const MX& dep);
 
@@ -0,0 +1,214 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "process_pool.hpp"
+#include "exception.hpp"
+#include "global_options.hpp"
+
+#ifndef _WIN32
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif // _WIN32
+
+namespace casadi {
+
+#ifndef _WIN32
+  // Shared state at the start of the mapping
+  struct ProcessPoolHeader {
+    // Next iteration to be handed out
+    std::atomic<casadi_int> next;
+  };
+
+  // Job sent to a worker
+  struct ProcessPoolJob {
+    casadi_int n, chunk;
+  };
+
+  // Send or receive a fixed-size message, false on failure
+  static bool send_all(int fd, const void* buf, size_t sz) {
+    const char* p = static_cast<const char*>(buf);
+    while (sz>0) {
+      ssize_t r = send(fd, p, sz, MSG_NOSIGNAL);
+      if (r<0 && errno==EINTR) continue;
+      if (r<=0) return false;
+      p += r;
+      sz -= r;
+    }
+    return true;
+  }
+
+  static bool recv_all(int fd, void* buf, size_t sz) {
+    char* p = static_cast<char*>(buf);
+    while (sz>0) {
+      ssize_t r = recv(fd, p, sz, 0);
+      if (r<0 && errno==EINTR) continue;
+      if (r<=0) return false;
+      p += r;
+      sz -= r;
+    }
+    return true;
+  }
+
+  bool ProcessPool::available() {
+    return std::atomic<casadi_int>().is_lock_free();
+  }
+
+  casadi_int ProcessPool::default_size() {
+    casadi_int n = GlobalOptions::max_num_threads;
+    if (n<=0) n = sysconf(_SC_NPROCESSORS_ONLN);
+    return std::max(n, casadi_int(1));
+  }
+
+  ProcessPool::ProcessPool(casadi_int n_proc, size_t sz, const Task& task) : broken_(false) {
+    casadi_assert(available(), "Process-based parallelization not supported on this platform");
+    // Shared mapping, header padded to keep the buffer aligned
+    size_t header_sz = (sizeof(ProcessPoolHeader) + 63)/64*64;
+    mapping_sz_ = header_sz + sz;
+    mapping_ = mmap(nullptr, mapping_sz_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    casadi_assert(mapping_!=MAP_FAILED, "mmap failed: " + std::string(strerror(errno)));
+    new (mapping_) ProcessPoolHeader();
+    buffer_ = static_cast<char*>(mapping_) + header_sz;
+    // Fork workers
+    for (casadi_int k=0; k<n_proc; ++k) {
+      int fd[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd)) {
+        casadi_warning("socketpair failed: " + std::string(strerror(errno)));
+        break;
+      }
+      // Avoid output buffered before forking being written twice
+      fflush(nullptr);
+      pid_t pid = fork();
+      if (pid==0) {
+        // Worker: drop the sockets of the other workers
+        close(fd[0]);
+        for (int w : workers_) close(w);
+        work(fd[1], mapping_, buffer_, task);
+      }
+      close(fd[1]);
+      if (pid<0) {
+        close(fd[0]);
+        casadi_warning("fork failed: " + std::string(strerror(errno)));
+        break;
+      }
+      workers_.push_back(fd[0]);
+      pid_.push_back(pid);
+    }
+    casadi_assert(!workers_.empty(), "Could not start any worker process");
+  }
+
+  ProcessPool::~ProcessPool() {
+    // Closing the socket terminates the worker
+    for (int w : workers_) close(w);
+    for (casadi_int pid : pid_) {
+      while (waitpid(static_cast<pid_t>(pid), nullptr, 0)<0 && errno==EINTR) {}
+    }
+    munmap(mapping_, mapping_sz_);
+  }
+
+  void ProcessPool::work(int fd, void* header, void* buffer, const Task& task) {
+    auto h = static_cast<ProcessPoolHeader*>(header);
+    ProcessPoolJob job;
+    while (recv_all(fd, &job, sizeof(job))) {
+      int flag = 0;
+      casadi_int i0;
+      while ((i0 = h->next.fetch_add(job.chunk)) < job.n) {
+        casadi_int i1 = std::min(i0 + job.chunk, job.n);
+        for (casadi_int i=i0; i<i1; ++i) {
+          try {
+            if (task(i, buffer)) flag = 1;
+          } catch (std::exception& e) {
+            flag = 1;
+            casadi_warning("Exception raised: " + std::string(e.what()));
+          } catch (...) {
+            flag = 1;
+            casadi_warning("Uncaught exception.");
+          }
+        }
+      }
+      if (!send_all(fd, &flag, sizeof(flag))) break;
+    }
+    // Skip destructors and exit handlers inherited from the parent
+    _exit(0);
+  }
+
+  int ProcessPool::run(casadi_int n, casadi_int chunk) {
+    if (broken_) return 1;
+    if (chunk<=0) chunk = std::max(n/(4*size()), casadi_int(1));
+    static_cast<ProcessPoolHeader*>(mapping_)->next = 0;
+    // Start the job in all workers
+    ProcessPoolJob job = {n, chunk};
+    for (int w : workers_) {
+      if (!send_all(w, &job, sizeof(job))) broken_ = true;
+    }
+    // Collect return flags
+    int ret = 0;
+    for (int w : workers_) {
+      int flag;
+      if (broken_ || !recv_all(w, &flag, sizeof(flag))) {
+        broken_ = true;
+      } else if (flag) {
+        ret = 1;
+      }
+    }
+    if (broken_) {
+      casadi_warning("A worker process terminated unexpectedly.");
+      return 1;
+    }
+    return ret;
+  }
+#else // _WIN32
+  bool ProcessPool::available() {
+    return false;
+  }
+
+  casadi_int ProcessPool::default_size() {
+    return 1;
+  }
+
+  ProcessPool::ProcessPool(casadi_int n_proc, size_t sz, const Task& task)
+      : mapping_(nullptr), mapping_sz_(0), buffer_(nullptr), broken_(true) {
+    casadi_error("Process-based parallelization not supported on this platform");
+  }
+
+  ProcessPool::~ProcessPool() {
+  }
+
+  void ProcessPool::work(int fd, void* header, void* buffer, const Task& task) {
+  }
+
+  int ProcessPool::run(casadi_int n, casadi_int chunk) {
+    return 1;
+  }
+#endif // _WIN32
+
+} // namespace casadi
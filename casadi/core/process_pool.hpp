@@ -0,0 +1,98 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_PROCESS_POOL_HPP
+#define CASADI_PROCESS_POOL_HPP
+
+#include "casadi_common.hpp"
+#include <functional>
+
+/// \cond INTERNAL
+namespace casadi {
+
+  /** \brief Pool of forked worker processes sharing a memory buffer
+
+      The workers are forked once, at construction, and inherit the state of
+      the calling process at that point, including the task. Data is exchanged
+      through an anonymous shared memory mapping, visible to all processes.
+      Iterations are handed out dynamically via a counter in shared memory.
+      Only available on POSIX systems.
+  */
+  class CASADI_EXPORT ProcessPool {
+  public:
+    /// Work item, evaluated in a worker process with the shared buffer. Nonzero on failure.
+    typedef std::function<int(casadi_int i, void* buffer)> Task;
+
+    /** \brief Fork n_proc workers sharing a buffer of sz bytes
+        The buffer is allocated before forking and may be accessed by the task. */
+    ProcessPool(casadi_int n_proc, size_t sz, const Task& task);
+
+    /// Destructor, terminates the workers
+    ~ProcessPool();
+
+    /// Is process-based parallelization supported on this platform?
+    static bool available();
+
+    /// Default number of workers: GlobalOptions::max_num_threads (0: number of cores)
+    static casadi_int default_size();
+
+    /// Number of worker processes
+    casadi_int size() const { return static_cast<casadi_int>(workers_.size());}
+
+    /// Shared buffer
+    void* buffer() const { return buffer_;}
+
+    /** \brief Evaluate task(i) for i = 0, ..., n-1 in the workers, blocking
+        Returns nonzero if any iteration failed or a worker died, after which
+        the pool is no longer usable (see broken()). */
+    int run(casadi_int n, casadi_int chunk);
+
+    /// Has a worker terminated unexpectedly?
+    bool broken() const { return broken_;}
+
+  private:
+    // Main loop of a worker process
+    static void work(int fd, void* header, void* buffer, const Task& task);
+
+    // Communication sockets, one per worker
+    std::vector<int> workers_;
+
+    // Process ids of the workers
+    std::vector<casadi_int> pid_;
+
+    // Shared mapping: header followed by the user buffer
+    void* mapping_;
+    size_t mapping_sz_;
+    void* buffer_;
+
+    // Worker failure
+    bool broken_;
+  };
+
+} // namespace casadi
+/// \endcond
+
+#endif // CASADI_PROCESS_POOL_HPP
@@ -134,8 +134,18 @@ namespace casadi {
     }
 
     // Perform operation inplace
-    g << g.rank1(g.work(arg[0], dep(0).nnz()), sparsity(), g.workel(arg[1]),
-                         g.work(arg[2], dep(2).nnz()), g.work(arg[3], dep(3).nnz())) << "\n";
+    std::string A = g.work(res[0], nnz()), x = g.work(arg[2], dep(2).nnz()),
+      y = g.work(arg[3], dep(3).nnz());
+    casadi_int m = size1(), n = size2();
+    bool blas = sparsity().is_dense() && g.use_cblas(m*n);
+    if (blas) {
+      g << "#ifdef CASADI_WITH_CBLAS\n";
+      g << "cblas_dger(CblasColMajor, " << m << ", " << n << ", " << g.workel(arg[1]) << ", "
+        << x << ", 1, " << y << ", 1, " << A << ", " << m << ");\n";
+      g << "#else\n";
+    }
+    g << g.rank1(A, sparsity(), g.workel(arg[1]), x, y) << "\n";
+    if (blas) g << "#endif\n";
   }
 
 } // namespace casadi
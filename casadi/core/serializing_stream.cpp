@@ -138,6 +138,7 @@ namespace casadi {
       e = n;
     }
 
+#ifndef CASADI_INT32
     void DeserializingStream::unpack(int& e) {
       assert_decoration('i');
       int32_t n;
@@ -153,6 +154,7 @@ namespace casadi {
       const char* c = reinterpret_cast<const char*>(&n);
       for (int j=0;j<4;++j) pack(c[j]);
     }
+#endif // CASADI_INT32
 
     void DeserializingStream::unpack(bool& e) {
       assert_decoration('b');
@@ -90,7 +90,9 @@ namespace casadi {
     void unpack(GenericType& e);
     void unpack(std::ostream& s);
     void unpack(Slice& e);
+#ifndef CASADI_INT32
     void unpack(int& e);
+#endif // CASADI_INT32
     void unpack(bool& e);
     void unpack(casadi_int& e);
     void unpack(size_t& e);
@@ -218,7 +220,9 @@ namespace casadi {
     void pack(const Slice& e);
     void pack(const GenericType& e);
     void pack(std::istream& s);
+#ifndef CASADI_INT32
     void pack(int e);
+#endif // CASADI_INT32
     void pack(bool e);
     void pack(casadi_int e);
     void pack(size_t e);
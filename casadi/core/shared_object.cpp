@@ -28,6 +28,7 @@
 #include "function.hpp"
 #endif // WITH_EXTRA_CHECKS
 #include <typeinfo>
+#include <cstdint>
 
 using namespace std;
 namespace casadi {
@@ -132,7 +133,7 @@ namespace casadi {
   }
 
   casadi_int SharedObject::__hash__() const {
-    return reinterpret_cast<casadi_int>(get());
+    return static_cast<casadi_int>(reinterpret_cast<std::uintptr_t>(get()));
   }
 
   WeakRef::WeakRef(int dummy) {
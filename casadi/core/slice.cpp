@@ -45,12 +45,14 @@ namespace casadi {
   Slice::Slice(casadi_int start, casadi_int stop, casadi_int step) :
     start(start), stop(stop), step(step) { }
 
+#ifndef CASADI_INT32
   Slice::Slice(int start, int stop, int step) : start(start), stop(stop), step(step) {
   }
   Slice::Slice(int start, casadi_int stop, int step) : start(start), stop(stop), step(step) {
   }
   Slice::Slice(casadi_int start, int stop, int step) : start(start), stop(stop), step(step) {
   }
+#endif // CASADI_INT32
 
   Slice Slice::operator-(casadi_int i) const {
     return Slice(start==std::numeric_limits<casadi_int>::min() ? start : start-i,
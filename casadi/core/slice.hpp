@@ -60,9 +60,11 @@ namespace casadi {
 
     /// A slice
     Slice(casadi_int start, casadi_int stop, casadi_int step=1);
+#ifndef CASADI_INT32
     Slice(int start, int stop, int step=1);
     Slice(int start, casadi_int stop, int step=1);
     Slice(casadi_int start, int stop, int step=1);
+#endif // CASADI_INT32
 
     /// Get a vector of indices
     std::vector<casadi_int> all() const;
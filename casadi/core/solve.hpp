@@ -90,7 +90,16 @@ namespace casadi {
                   const std::vector<casadi_int>& res) const override;
 
     /** \brief Get required length of w field */
-    size_t sz_w() const override;
+    size_t sz_w() const override { return sparsity().size1();}
+
+    /** \brief Get required length of w field in generated code */
+    size_t codegen_sz_w(const CodeGenerator& g) const override;
+
+    /** \brief Solve in a widened copy of the system in generated code? */
+    bool codegen_mixed(const CodeGenerator& g) const;
+
+    /** \brief Factorize with LAPACKE in generated code, when available? */
+    bool codegen_lapacke(const CodeGenerator& g) const;
 
     /** Obtain information about function */
     Dict info() const override {
@@ -251,8 +251,26 @@ namespace casadi {
   }
 
   template<bool Tr>
-  size_t Solve<Tr>::sz_w() const {
-    return sparsity().size1();
+  bool Solve<Tr>::codegen_mixed(const CodeGenerator& g) const {
+    return g.solve_real()!="casadi_real" && linsol_->has_codegen_mixed();
+  }
+
+  template<bool Tr>
+  bool Solve<Tr>::codegen_lapacke(const CodeGenerator& g) const {
+    casadi_int n = dep(1).size1();
+    return (codegen_mixed(g) || g.solve_real()=="casadi_real")
+      && dep(1).sparsity().is_dense() && g.has_lapacke(n*n*(n+dep(0).size2()));
+  }
+
+  template<bool Tr>
+  size_t Solve<Tr>::codegen_sz_w(const CodeGenerator& g) const {
+    // Widened copies, dense LU factors and pivots, cf. generate
+    size_t sz_solve = 0;
+    if (codegen_mixed(g)) sz_solve += dep(1).nnz() + nnz();
+    if (codegen_lapacke(g)) sz_solve += dep(1).nnz() + dep(1).size1();
+    // Stored in solve precision, which may be wider than casadi_real, plus alignment
+    if (sz_solve>0 && g.solve_real()!="casadi_real") sz_solve = 2*sz_solve + 1;
+    return sz_w() + sz_solve;
   }
 
   template<bool Tr>
@@ -274,8 +292,57 @@ namespace casadi {
     if (arg[0]!=res[0]) {
       g << g.copy(g.work(arg[0], nnz()), nnz(), "rr") << '\n';
     }
+
+    // Scratch in solve precision after the linear solver part of the work vector, cf. codegen_sz_w
+    std::string t = g.solve_real();
+    std::string sw = "w+" + str(sparsity().size1());
+    if (t!="casadi_real") {
+      // Align to the solve precision
+      g.add_include("stddef.h");
+      sw = "(" + t + "*) (" + sw + "+((size_t) (" + sw + ") % sizeof(" + t + "))"
+        "/sizeof(casadi_real))";
+    }
+
+    // Mixed precision: solve a widened copy of the system, round the solution back
+    std::string A = "ss", x = "rr";
+    bool mixed = codegen_mixed(g);
+    if (mixed) {
+      g.local("sw", t, "*");
+      g.local("i", "casadi_int");
+      g << "sw = " << sw << ";\n";
+      g << "for (i=0; i<" << dep(1).nnz() << "; ++i) sw[i] = ss[i];\n";
+      g << "for (i=0; i<" << nnz() << "; ++i) sw[" << dep(1).nnz() << "+i] = rr[i];\n";
+      A = "sw";
+      x = "sw+" + str(dep(1).nnz());
+      sw = "sw+" + str(dep(1).nnz() + nnz());
+    }
+
+    // Dense A: LU factorization with partial pivoting in LAPACKE when available
+    casadi_int n = dep(1).size1();
+    bool lapack = codegen_lapacke(g) && g.use_lapacke(n*n*(n+nrhs));
+    if (lapack) {
+      g.local("i", "casadi_int");
+      g << "#ifdef CASADI_WITH_LAPACKE\n";
+      g << "{\n";
+      g << "double* lu = " << sw << ";\n";
+      g << "lapack_int* ipiv = (lapack_int*) (lu+" << n*n << ");\n";
+      g << "for (i=0; i<" << n*n << "; ++i) lu[i] = " << A << "[i];\n";
+      g << "if (LAPACKE_dgetrf(LAPACK_COL_MAJOR, " << n << ", " << n << ", lu, " << n
+        << ", ipiv)) return 1;\n";
+      g << "if (LAPACKE_dgetrs(LAPACK_COL_MAJOR, '" << (Tr ? 'T' : 'N') << "', "
+        << n << ", " << nrhs << ", lu, " << n << ", ipiv, " << x << ", " << n
+        << ")) return 1;\n";
+      g << "}\n";
+      g << "#else\n";
+    }
     // Solver specific codegen
-    linsol_->generate(g, "ss", "rr", nrhs, Tr);
+    linsol_->generate(g, A, x, nrhs, Tr);
+    if (lapack) g << "#endif\n";
+
+    if (mixed) {
+      g << "for (i=0; i<" << nnz() << "; ++i) rr[i] = (casadi_real) sw["
+        << dep(1).nnz() << "+i];\n";
+    }
   }
 
   template<bool Tr>
@@ -27,6 +27,7 @@
 #include "sx.hpp"
 #include <stack>
 #include <cassert>
+#include <cstdint>
 #include "calculus.hpp"
 #include "constant_sx.hpp"
 #include "symbolic_sx.hpp"
@@ -510,7 +511,7 @@ namespace casadi {
   }
 
   casadi_int SXElem::__hash__() const {
-    return reinterpret_cast<casadi_int>(node);
+    return static_cast<casadi_int>(reinterpret_cast<std::uintptr_t>(node));
   }
 
   // node corresponding to a constant 0
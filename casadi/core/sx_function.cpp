@@ -37,6 +37,7 @@
 #include "global_options.hpp"
 #include "casadi_interrupt.hpp"
 #include "serializing_stream.hpp"
+#include "thread_pool.hpp"
 
 namespace casadi {
 
@@ -90,6 +91,72 @@ namespace casadi {
     return 0;
   }
 
+  const casadi_int SXFunction::batch_lanes;
+
+  int SXFunction::eval_batch(const double** arg, double** res, casadi_int n,
+      const std::vector<bool>& batched_in, bool parallel) const {
+    // Fall back to evaluating one by one if the evaluation is monitored or compiled
+    if (!free_vars_.empty() || eval_ || print_in_ || print_out_ || dump_in_ || dump_out_
+        || dump_ || record_time_) {
+      return FunctionInternal::eval_batch(arg, res, n, batched_in, parallel);
+    }
+    // Blocks of lanes
+    casadi_int n_blocks = (n + batch_lanes - 1) / batch_lanes;
+    casadi_int n_threads = parallel ? std::min(ThreadPool::size(), n_blocks) : 1;
+    if (n_threads<=1) {
+      std::vector<double> wl(worksize_ * batch_lanes);
+      for (casadi_int b=0; b<n_blocks; ++b) {
+        casadi_int k0 = b * batch_lanes;
+        eval_lanes(arg, res, k0, std::min(batch_lanes, n - k0), batched_in, get_ptr(wl));
+      }
+    } else {
+      std::vector<std::vector<double>> wl(n_threads,
+        std::vector<double>(worksize_ * batch_lanes));
+      ThreadPool::instance().run(n_blocks, 1, [&](casadi_int b, casadi_int t) {
+        casadi_int k0 = b * batch_lanes;
+        eval_lanes(arg, res, k0, std::min(batch_lanes, n - k0), batched_in, get_ptr(wl[t]));
+      }, n_threads);
+    }
+    return 0;
+  }
+
+  void SXFunction::eval_lanes(const double** arg, double** res, casadi_int k0, casadi_int m,
+      const std::vector<bool>& batched_in, double* wl) const {
+    const casadi_int L = batch_lanes;
+    for (auto&& e : algorithm_) {
+      double* w0 = wl + e.i0 * L;
+      switch (e.op) {
+      case OP_CONST:
+        std::fill(w0, w0 + m, e.d);
+        break;
+      case OP_INPUT:
+        {
+          const double* a = arg[e.i1];
+          if (a==nullptr) {
+            std::fill(w0, w0 + m, 0.);
+          } else if (batched_in[e.i1]) {
+            casadi_int nnz = nnz_in(e.i1);
+            a += k0 * nnz + e.i2;
+            for (casadi_int j=0; j<m; ++j) w0[j] = a[j * nnz];
+          } else {
+            std::fill(w0, w0 + m, a[e.i2]);
+          }
+        }
+        break;
+      case OP_OUTPUT:
+        if (res[e.i0]!=nullptr) {
+          casadi_int nnz = nnz_out(e.i0);
+          double* r = res[e.i0] + k0 * nnz + e.i2;
+          const double* w1 = wl + e.i1 * L;
+          for (casadi_int j=0; j<m; ++j) r[j * nnz] = w1[j];
+        }
+        break;
+      default:
+        casadi_math<double>::fun(e.op, wl + e.i1 * L, wl + e.i2 * L, w0, m);
+      }
+    }
+  }
+
   bool SXFunction::is_smooth() const {
     // Go through all nodes and check if any node is non-smooth
     for (auto&& a : algorithm_) {
@@ -150,32 +217,309 @@ namespace casadi {
     }
   }
 
+  // Consecutive repetitions of an instruction block, cf. CodeGenerator option "reroll"
+  struct SXLoop {
+    casadi_int begin, len, n;
+  };
+
+  // Same operation and constant, operands may differ
+  static bool sx_isomorphic(const ScalarAtomic& a, const ScalarAtomic& b) {
+    return a.op==b.op && (a.op!=OP_CONST || a.d==b.d);
+  }
+
+  // Find repeated blocks covering at least min_size instructions, longest coverage first
+  static std::vector<SXLoop> sx_reroll(const std::vector<ScalarAtomic>& alg, casadi_int min_size) {
+    // Longest block considered
+    const casadi_int max_len = 256;
+    casadi_int n_alg = alg.size();
+    std::vector<SXLoop> loops;
+    casadi_int k = 0;
+    while (k<n_alg) {
+      SXLoop best = {k, 1, 1};
+      for (casadi_int len=1; len<=max_len && k+2*len<=n_alg; ++len) {
+        // Count repetitions of the block starting at k
+        casadi_int n = 1;
+        while (k+(n+1)*len<=n_alg) {
+          casadi_int j;
+          for (j=0; j<len; ++j) {
+            if (!sx_isomorphic(alg[k+j], alg[k+n*len+j])) break;
+          }
+          if (j<len) break;
+          n++;
+        }
+        if (n*len>best.n*best.len) best = {k, len, n};
+      }
+      if (best.n>1 && best.n*best.len>=min_size) {
+        loops.push_back(best);
+        k += best.n*best.len;
+      } else {
+        k++;
+      }
+    }
+    return loops;
+  }
+
+  std::string SXFunction::codegen_instruction(CodeGenerator& g, const AlgEl& a,
+                                              const std::string& x0, const std::string& x1,
+                                              const std::string& x2) {
+    std::stringstream s;
+    if (a.op==OP_OUTPUT) {
+      s << "if (res[" << x0 << "]!=0) res[" << x0 << "][" << x2 << "]=" << x1;
+    } else {
+      // Where to store the result
+      s << x0 << "=";
+
+      // What to store
+      if (a.op==OP_CONST) {
+        s << g.constant(a.d);
+      } else if (a.op==OP_INPUT) {
+        s << "arg[" << x1 << "]? arg[" << x1 << "][" << x2 << "] : 0";
+      } else {
+        casadi_int ndep = casadi_math<double>::ndeps(a.op);
+        casadi_assert_dev(ndep>0);
+        if (ndep==1) s << g.print_op(a.op, x1);
+        if (ndep==2) s << g.print_op(a.op, x1, x2);
+      }
+    }
+    return s.str();
+  }
+
+  casadi_int SXFunction::codegen_sz_w(const CodeGenerator& g) const {
+    // Work vector elements are local variables unless passed through w
+    if (g.avoid_stack_) return sz_w();
+    // Split parts exchange live values through w
+    if (g.split_size>0 && algorithm_.size()>g.split_size) return sz_w();
+    // Rerolled loops address work vector elements through w
+    if (g.reroll>0 && !sx_reroll(algorithm_, g.reroll).empty()) return sz_w();
+    return 0;
+  }
+
   void SXFunction::codegen_body(CodeGenerator& g) const {
+    // Split huge bodies to keep compile time and compiler memory bounded
+    if (g.split_size>0 && algorithm_.size()>g.split_size) {
+      codegen_body_split(g);
+      return;
+    }
+
+    // Repeated instruction blocks to be emitted as loops
+    std::vector<SXLoop> loops;
+    if (g.reroll>0) loops = sx_reroll(algorithm_, g.reroll);
+
+    // Work vector elements accessed in a loop are addressed through w
+    std::vector<bool> in_w(worksize_, false);
+    for (auto&& l : loops) {
+      for (casadi_int k=l.begin; k<l.begin+l.len*l.n; ++k) {
+        const AlgEl& a = algorithm_[k];
+        if (a.op==OP_OUTPUT) {
+          in_w[a.i1] = true;
+        } else {
+          in_w[a.i0] = true;
+          casadi_int ndep = a.op==OP_CONST || a.op==OP_INPUT ? 0 : casadi_math<double>::ndeps(a.op);
+          if (ndep>0) in_w[a.i1] = true;
+          if (ndep>1) in_w[a.i2] = true;
+        }
+      }
+    }
+    auto work = [&](casadi_int i) { return in_w[i] ? "w[" + str(i) + "]" : g.sx_work(i);};
 
     // Run the algorithm
-    for (auto&& a : algorithm_) {
+    auto l = loops.begin();
+    for (casadi_int k=0; k<algorithm_.size(); ++k) {
+      if (l!=loops.end() && l->begin==k) {
+        codegen_loop(g, l->begin, l->len, l->n);
+        k += l->len*l->n - 1;
+        ++l;
+        continue;
+      }
+      const AlgEl& a = algorithm_[k];
+      if (a.op==OP_OUTPUT) {
+        g << codegen_instruction(g, a, str(a.i0), work(a.i1), str(a.i2));
+      } else if (a.op==OP_CONST || a.op==OP_INPUT) {
+        g << codegen_instruction(g, a, work(a.i0), str(a.i1), str(a.i2));
+      } else {
+        casadi_int ndep = casadi_math<double>::ndeps(a.op);
+        g << codegen_instruction(g, a, work(a.i0), work(a.i1), ndep>1 ? work(a.i2) : "");
+      }
+      g  << ";\n";
+    }
+  }
+
+  void SXFunction::codegen_loop(CodeGenerator& g, casadi_int begin, casadi_int len,
+                                casadi_int n) const {
+    // Operand expressions in the loop index: affine if possible, else a table
+    auto index = [&](const std::vector<casadi_int>& v) {
+      casadi_int stride = v[1]-v[0];
+      for (casadi_int r=2; r<n; ++r) {
+        if (v[r]-v[r-1]!=stride) return g.constant(v) + "[i]";
+      }
+      if (stride==0) return str(v[0]);
+      std::string s = v[0]==0 ? "" : str(v[0]);
+      if (stride<0) {
+        s += "-";
+      } else if (!s.empty()) {
+        s += "+";
+      }
+      if (std::abs(stride)!=1) s += str(std::abs(stride)) + "*";
+      return s + "i";
+    };
+    g.local("i", "casadi_int");
+    g << "for (i=0; i<" << n << "; ++i) {\n";
+    std::vector<casadi_int> v0(n), v1(n), v2(n);
+    for (casadi_int j=0; j<len; ++j) {
+      const AlgEl& a = algorithm_[begin+j];
+      for (casadi_int r=0; r<n; ++r) {
+        const AlgEl& e = algorithm_[begin+r*len+j];
+        v0[r] = e.i0;
+        v1[r] = a.op==OP_CONST ? 0 : e.i1;
+        v2[r] = a.op==OP_CONST ? 0 : e.i2;
+      }
       if (a.op==OP_OUTPUT) {
-        g << "if (res[" << a.i0 << "]!=0) "
-          << g.res(a.i0) << "[" << a.i2 << "]=" << g.sx_work(a.i1);
+        g << codegen_instruction(g, a, index(v0), "w[" + index(v1) + "]", index(v2));
+      } else if (a.op==OP_CONST || a.op==OP_INPUT) {
+        g << codegen_instruction(g, a, "w[" + index(v0) + "]", index(v1), index(v2));
       } else {
+        casadi_int ndep = casadi_math<double>::ndeps(a.op);
+        g << codegen_instruction(g, a, "w[" + index(v0) + "]", "w[" + index(v1) + "]",
+                                 ndep>1 ? "w[" + index(v2) + "]" : "");
+      }
+      g << ";\n";
+    }
+    g << "}\n";
+  }
+
+  void SXFunction::codegen_body_split(CodeGenerator& g) const {
+    // Instruction ranges of the parts
+    std::vector<casadi_int> part_begin;
+    for (casadi_int k=0; k<algorithm_.size(); k+=g.split_size) part_begin.push_back(k);
+    part_begin.push_back(algorithm_.size());
+    casadi_int n_part = part_begin.size()-1;
+
+    // Work vector elements read before written (live_in) and written in each part
+    std::vector<std::vector<casadi_int> > live_in(n_part), written(n_part);
+    std::vector<casadi_int> stamp(worksize_, -1);
+    for (casadi_int k=0; k<n_part; ++k) {
+      // stamp: 2k read in part k, 2k+1 written in part k
+      for (casadi_int i=part_begin[k]; i<part_begin[k+1]; ++i) {
+        const AlgEl& a = algorithm_[i];
+        casadi_int ndep = a.op==OP_OUTPUT ? 1 : casadi_math<double>::ndeps(a.op);
+        casadi_int dep[2] = {a.i1, a.i2};
+        for (casadi_int d=0; d<ndep && a.op!=OP_INPUT; ++d) {
+          if (stamp[dep[d]]<2*k) {
+            live_in[k].push_back(dep[d]);
+            stamp[dep[d]] = 2*k;
+          }
+        }
+        if (a.op!=OP_OUTPUT && stamp[a.i0]!=2*k+1) {
+          written[k].push_back(a.i0);
+          stamp[a.i0] = 2*k+1;
+        }
+      }
+    }
+
+    // Written elements that are read by a later part must be stored in w
+    std::vector<std::vector<casadi_int> > live_out(n_part);
+    std::vector<bool> live(worksize_, false);
+    for (casadi_int k=n_part-1; k>=0; --k) {
+      for (casadi_int i : written[k]) {
+        if (live[i]) live_out[k].push_back(i);
+        live[i] = false;
+      }
+      for (casadi_int i : live_in[k]) live[i] = true;
+    }
 
-        // Where to store the result
-        g << g.sx_work(a.i0) << "=";
+    // Generate the parts, work vector elements are local variables within a part
+    std::string fname = codegen_name(g, false);
+    for (casadi_int k=0; k<n_part; ++k) {
+      std::vector<std::string> wk(worksize_);
+      std::set<casadi_int> used(live_in[k].begin(), live_in[k].end());
+      used.insert(written[k].begin(), written[k].end());
+      for (casadi_int i : used) wk[i] = g.avoid_stack_ ? "w[" + str(i) + "]" : "a" + str(i);
+      std::stringstream s;
+      if (!g.avoid_stack_ && !used.empty()) {
+        s << "  casadi_real ";
+        for (auto it=used.begin(); it!=used.end(); ++it) {
+          s << (it==used.begin() ? "" : ", ") << wk[*it];
+        }
+        s << ";\n";
+        for (casadi_int i : live_in[k]) s << "  " << wk[i] << "=w[" << i << "];\n";
+      }
+      for (casadi_int i=part_begin[k]; i<part_begin[k+1]; ++i) {
+        const AlgEl& a = algorithm_[i];
+        s << "  ";
+        if (a.op==OP_OUTPUT) {
+          s << "if (" << g.res(a.i0) << "!=0) " << g.res(a.i0) << "[" << a.i2 << "]=" << wk[a.i1];
+        } else {
+          s << wk[a.i0] << "=";
+          if (a.op==OP_CONST) {
+            s << g.constant(a.d);
+          } else if (a.op==OP_INPUT) {
+            s << g.arg(a.i1) << "? " << g.arg(a.i1) << "[" << a.i2 << "] : 0";
+          } else {
+            casadi_int ndep = casadi_math<double>::ndeps(a.op);
+            casadi_assert_dev(ndep>0);
+            if (ndep==1) s << g.print_op(a.op, wk[a.i1]);
+            if (ndep==2) s << g.print_op(a.op, wk[a.i1], wk[a.i2]);
+          }
+        }
+        s << ";\n";
+      }
+      if (!g.avoid_stack_) {
+        for (casadi_int i : live_out[k]) s << "  w[" << i << "]=" << wk[i] << ";\n";
+      }
+      std::string pname = g.add_part(fname + "_p" + str(k), s.str());
+      g << pname << "(arg, res, w);\n";
+    }
+  }
 
-        // What to store
+  void SXFunction::codegen_batch_body(CodeGenerator& g) const {
+    // Inputs and outputs referenced by the algorithm
+    std::vector<bool> used_in(n_in_, false), used_out(n_out_, false);
+    for (auto&& a : algorithm_) {
+      if (a.op==OP_INPUT) used_in[a.i1] = true;
+      if (a.op==OP_OUTPUT) used_out[a.i0] = true;
+    }
+    // Input and output pointers, must not be null to keep the loop free of branches
+    std::vector<std::string> ptr;
+    g << "casadi_int j;\n";
+    for (casadi_int i=0; i<n_in_; ++i) {
+      if (!used_in[i]) continue;
+      g << "const casadi_real* x" << i << " = arg[" << i << "];\n";
+      ptr.push_back("x" + str(i));
+    }
+    for (casadi_int i=0; i<n_out_; ++i) {
+      if (!used_out[i]) continue;
+      g << "casadi_real* r" << i << " = res[" << i << "];\n";
+      ptr.push_back("r" + str(i));
+    }
+    for (auto&& p : ptr) g << "if (!" << p << ") return 1;\n";
+    // One lane per evaluation, work variables private to the lane
+    g << "#pragma omp simd\n"
+      << "for (j=0; j<n; ++j) {\n";
+    if (worksize_>0) {
+      g << "casadi_real ";
+      for (casadi_int i=0; i<worksize_; ++i) g << (i==0 ? "" : ", ") << "a" << i;
+      g << ";\n";
+    }
+    for (auto&& a : algorithm_) {
+      if (a.op==OP_OUTPUT) {
+        g << "r" << a.i0 << "[" << a.i2 << "*n+j]=a" << a.i1;
+      } else {
+        g << "a" << a.i0 << "=";
         if (a.op==OP_CONST) {
           g << g.constant(a.d);
         } else if (a.op==OP_INPUT) {
-          g << g.arg(a.i1) << "? " << g.arg(a.i1) << "[" << a.i2 << "] : 0";
+          g << "x" << a.i1 << "[" << a.i2 << "*n+j]";
         } else {
           casadi_int ndep = casadi_math<double>::ndeps(a.op);
           casadi_assert_dev(ndep>0);
-          if (ndep==1) g << g.print_op(a.op, g.sx_work(a.i1));
-          if (ndep==2) g << g.print_op(a.op, g.sx_work(a.i1), g.sx_work(a.i2));
+          std::string x1 = "a" + str(a.i1), x2 = "a" + str(a.i2);
+          if (ndep==1) g << g.print_op(a.op, x1);
+          if (ndep==2) g << g.print_op(a.op, x1, x2);
         }
       }
-      g  << ";\n";
+      g << ";\n";
     }
+    g << "}\n";
   }
 
   const Options SXFunction::options_
@@ -770,6 +1114,190 @@ namespace casadi {
     }
   }
 
+  /// Add a contribution to a symmetric second order adjoint: W(i, j) += v
+  static void edge_add(std::vector<std::map<casadi_int, SXElem> >& W,
+                       casadi_int i, casadi_int j, const SXElem& v) {
+    if (v.is_zero()) return;
+    auto it = W[i].insert(std::make_pair(j, SXElem(0))).first;
+    it->second = it->second + v;
+    if (i!=j) W[j][i] = it->second;
+  }
+
+  SX SXFunction::hess_edge_pushing(casadi_int iind, casadi_int oind, SX& g) const {
+    casadi_assert(sparsity_out_.at(oind).is_scalar(),
+                  "Edge pushing Hessian requires a scalar output");
+    g = SX::zeros(sparsity_in_.at(iind));
+    std::vector<casadi_int> hrow, hcol;
+    std::vector<SXElem> hnz;
+
+    // Number of instructions, each non-output instruction defines one node
+    casadi_int nalg = algorithm_.size();
+
+    // Nodes defining the operands, input nonzero of input nodes, output node
+    std::vector<casadi_int> dep0(nalg, -1), dep1(nalg, -1), in_nz(nalg, -1);
+    casadi_int out_node = -1;
+
+    // Does a node depend on the input?
+    std::vector<bool> active(nalg, false);
+
+    // Expression of each node
+    std::vector<SXElem> ex(nalg);
+
+    // Resolve work vector elements to the nodes defining them
+    std::vector<casadi_int> w_node(worksize_, -1);
+    auto b_it = operations_.begin();
+    for (casadi_int k=0; k<nalg; ++k) {
+      const AlgEl& a = algorithm_[k];
+      switch (a.op) {
+      case OP_OUTPUT:
+        if (a.i0==oind) out_node = w_node[a.i1];
+        continue;
+      case OP_INPUT:
+        if (a.i1==iind) {
+          active[k] = true;
+          in_nz[k] = a.i2;
+        }
+        break;
+      case OP_CONST:
+      case OP_PARAMETER:
+        break;
+      default:
+        ex[k] = *b_it++;
+        dep0[k] = w_node[a.i1];
+        active[k] = active[dep0[k]];
+        if (casadi_math<double>::ndeps(a.op)==2) {
+          dep1[k] = w_node[a.i2];
+          active[k] = active[k] || active[dep1[k]];
+        }
+      }
+      w_node[a.i0] = k;
+    }
+
+    // Quick return if no dependency
+    if (out_node<0 || !active[out_node]) {
+      return SX(numel_in(iind), numel_in(iind));
+    }
+
+    // Second order partial derivatives, one template per operation
+    std::map<casadi_int, Function> d2_fcn;
+
+    // First and second order adjoints
+    std::vector<SXElem> v(nalg, 0);
+    std::vector<std::map<casadi_int, SXElem> > W(nalg);
+    v[out_node] = 1;
+
+    // Sweep backwards
+    std::vector<casadi_int> pred;
+    std::vector<SXElem> d, h;
+    for (casadi_int k=out_node; k>=0; --k) {
+      if (!active[k] || dep0[k]<0) continue;
+      const AlgEl& a = algorithm_[k];
+      bool binary = casadi_math<double>::ndeps(a.op)==2;
+      const SXElem& f = ex[k];
+      const SXElem& x = f->dep(0);
+      const SXElem& y = binary ? f->dep(1) : x;
+
+      // First order partial derivatives
+      SXElem dd[2];
+      casadi_math<SXElem>::der(a.op, x, y, f, dd);
+
+      // Second order partial derivatives
+      auto it = d2_fcn.find(a.op);
+      if (it==d2_fcn.end()) {
+        SX X = SX::sym("x"), Y = SX::sym("y");
+        SXElem F, D[2];
+        casadi_math<SXElem>::fun(a.op, X.scalar(), Y.scalar(), F);
+        casadi_math<SXElem>::der(a.op, X.scalar(), Y.scalar(), F, D);
+        SX H = SX::jacobian(vertcat(SX(D[0]), SX(D[1])), vertcat(X, Y));
+        it = d2_fcn.insert(std::make_pair(a.op,
+          Function("d2", {X, Y}, {H(0, 0), H(0, 1), H(1, 1)}))).first;
+      }
+      std::vector<SX> hh = it->second(std::vector<SX>{SX(x), SX(y)});
+
+      // Operands depending on the input, merging duplicates
+      pred.clear();
+      d.clear();
+      h.clear();
+      if (!binary) {
+        pred = {dep0[k]};
+        d = {dd[0]};
+        h = {hh[0].scalar()};
+      } else if (dep0[k]==dep1[k]) {
+        pred = {dep0[k]};
+        d = {dd[0] + dd[1]};
+        h = {hh[0].scalar() + 2*hh[1].scalar() + hh[2].scalar()};
+      } else {
+        // Hessian stored column-wise per pair (0,0), (0,1), (1,1)
+        pred = {dep0[k], dep1[k]};
+        d = {dd[0], dd[1]};
+        h = {hh[0].scalar(), hh[1].scalar(), hh[2].scalar()};
+      }
+
+      // Pushing: move the nonlinear edges incident to k to its operands
+      std::map<casadi_int, SXElem> Wk;
+      Wk.swap(W[k]);
+      for (auto&& e : Wk) {
+        casadi_int p = e.first;
+        if (p==k) continue;
+        W[p].erase(k);
+        for (casadi_int i=0; i<pred.size(); ++i) {
+          if (!active[pred[i]]) continue;
+          if (pred[i]==p) {
+            edge_add(W, p, p, 2*d[i]*e.second);
+          } else {
+            edge_add(W, p, pred[i], d[i]*e.second);
+          }
+        }
+      }
+      auto kk = Wk.find(k);
+      if (kk!=Wk.end()) {
+        for (casadi_int i=0; i<pred.size(); ++i) {
+          if (!active[pred[i]]) continue;
+          for (casadi_int j=i; j<pred.size(); ++j) {
+            if (!active[pred[j]]) continue;
+            edge_add(W, pred[i], pred[j], d[i]*d[j]*kk->second);
+          }
+        }
+      }
+
+      // Creating: nonlinear contributions of the operation itself
+      if (!v[k].is_zero()) {
+        if (pred.size()==1) {
+          edge_add(W, pred[0], pred[0], v[k]*h[0]);
+        } else {
+          if (active[pred[0]]) edge_add(W, pred[0], pred[0], v[k]*h[0]);
+          if (active[pred[0]] && active[pred[1]]) edge_add(W, pred[0], pred[1], v[k]*h[1]);
+          if (active[pred[1]]) edge_add(W, pred[1], pred[1], v[k]*h[2]);
+        }
+      }
+
+      // First order adjoints
+      for (casadi_int i=0; i<pred.size(); ++i) {
+        if (active[pred[i]]) v[pred[i]] += d[i]*v[k];
+      }
+      v[k] = 0;
+    }
+
+    // Collect gradient and Hessian from the input nodes
+    const Sparsity& sp = sparsity_in_.at(iind);
+    std::vector<casadi_int> col = sp.get_col();
+    for (casadi_int k=0; k<nalg; ++k) {
+      if (in_nz[k]<0) continue;
+      g.nonzeros()[in_nz[k]] += v[k];
+      for (auto&& e : W[k]) {
+        if (in_nz[e.first]<0) continue;
+        hrow.push_back(sp.row(in_nz[k]) + sp.size1()*col[in_nz[k]]);
+        hcol.push_back(sp.row(in_nz[e.first]) + sp.size1()*col[in_nz[e.first]]);
+        hnz.push_back(e.second);
+      }
+    }
+    std::vector<casadi_int> mapping;
+    Sparsity hsp = Sparsity::triplet(numel_in(iind), numel_in(iind), hrow, hcol, mapping, true);
+    SX H = SX::zeros(hsp);
+    for (casadi_int i=0; i<hnz.size(); ++i) H.nonzeros()[mapping[i]] += hnz[i];
+    return H;
+  }
+
   int SXFunction::
   sp_forward(const bvec_t** arg, bvec_t** res, casadi_int* iw, bvec_t* w, void* mem) const {
     // Fall back when forward mode not allowed
@@ -62,6 +62,17 @@ class CASADI_EXPORT SXFunction :
   /** \brief  Evaluate numerically, work vectors given */
   int eval(const double** arg, double** res, casadi_int* iw, double* w, void* mem) const override;
 
+  /** \brief  Evaluate numerically for n input sets, each instruction applied to a block of lanes */
+  int eval_batch(const double** arg, double** res, casadi_int n,
+                 const std::vector<bool>& batched_in, bool parallel) const override;
+
+  /** \brief  Evaluate the lanes k0, ..., k0+m-1 of a batch, wl holds worksize_ x batch_lanes */
+  void eval_lanes(const double** arg, double** res, casadi_int k0, casadi_int m,
+                  const std::vector<bool>& batched_in, double* wl) const;
+
+  /// Number of evaluations processed together by eval_batch
+  static const casadi_int batch_lanes = 64;
+
   /** \brief  evaluate symbolically while also propagating directional derivatives */
   int eval_sx(const SXElem** arg, SXElem** res,
               casadi_int* iw, SXElem* w, void* mem) const override;
@@ -117,6 +128,14 @@ class CASADI_EXPORT SXFunction :
   /** \brief Hessian (forward over adjoint) via source code transformation */
   SX hess(casadi_int iind=0, casadi_int oind=0);
 
+  /** \brief Hessian of a scalar output via edge pushing
+
+      Single reverse sweep over the algorithm accumulating second order
+      adjoints on pairs of nodes, no graph coloring needed.
+      The gradient is returned in \a g.
+  */
+  SX hess_edge_pushing(casadi_int iind, casadi_int oind, SX& g) const;
+
   /** \brief Get the number of atomic operations */
   casadi_int n_instructions() const override { return algorithm_.size();}
 
@@ -206,6 +225,26 @@ class CASADI_EXPORT SXFunction :
   /** \brief Generate code for the body of the C function */
   void codegen_body(CodeGenerator& g) const override;
 
+  /** \brief Generate the body as a sequence of calls to parts of bounded size */
+  void codegen_body_split(CodeGenerator& g) const;
+
+  /** \brief Work vector length reported by the generated _work function */
+  casadi_int codegen_sz_w(const CodeGenerator& g) const override;
+
+  /** \brief Print an instruction, operands given as expressions */
+  static std::string codegen_instruction(CodeGenerator& g, const AlgEl& a,
+                                         const std::string& x0, const std::string& x1,
+                                         const std::string& x2);
+
+  /** \brief Generate a loop over repetitions of an instruction block */
+  void codegen_loop(CodeGenerator& g, casadi_int begin, casadi_int len, casadi_int n) const;
+
+  /** \brief Can a batch entry point be generated? */
+  bool has_codegen_batch() const override { return free_vars_.empty();}
+
+  /** \brief Generate code for the body of the batch entry point */
+  void codegen_batch_body(CodeGenerator& g) const override;
+
   /** \brief  Propagate sparsity forward */
   int sp_forward(const bvec_t** arg, bvec_t** res,
                   casadi_int* iw, bvec_t* w, void* mem) const override;
@@ -578,6 +578,19 @@ namespace casadi {
   template<>
   SX CASADI_EXPORT SX::hessian(const SX &ex, const SX &arg, SX &g, const Dict& opts) {
     Dict all_opts = opts;
+    // Hessian construction strategy
+    auto it = all_opts.find("hessian_method");
+    if (it!=all_opts.end()) {
+      std::string method = it->second;
+      all_opts.erase(it);
+      if (method=="edge_pushing") {
+        Dict h_opts;
+        extract_from_dict(all_opts, "helper_options", h_opts);
+        Function h("hess_helper", {arg}, {ex}, h_opts);
+        return h.get<SXFunction>()->hess_edge_pushing(0, 0, g);
+      }
+      casadi_assert(method=="coloring", "Unknown Hessian method: " + method);
+    }
     if (!opts.count("symmetric")) all_opts["symmetric"] = true;
     g = gradient(ex, arg);
     return jacobian(g, arg, all_opts);
@@ -0,0 +1,315 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "thread_pool.hpp"
+#include "global_options.hpp"
+#include "exception.hpp"
+#include <chrono>
+
+#if defined(CASADI_WITH_THREAD) && !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace casadi {
+
+#ifdef CASADI_WITH_THREAD
+  // Is the current thread executing a task of the pool
+  static thread_local bool thread_pool_active = false;
+
+  // Mark the current thread as active for the lifetime of the object
+  struct ThreadPoolActive {
+    ThreadPoolActive() { thread_pool_active = true; }
+    ~ThreadPoolActive() { thread_pool_active = false; }
+  };
+#endif // CASADI_WITH_THREAD
+
+  ThreadSchedule to_schedule(const std::string& s) {
+    if (s=="static") return SCHEDULE_STATIC;
+    if (s=="dynamic") return SCHEDULE_DYNAMIC;
+    if (s=="guided") return SCHEDULE_GUIDED;
+    if (s=="work_stealing") return SCHEDULE_WORK_STEALING;
+    casadi_error("Unknown schedule '" + s + "'. "
+                 "Allowed: 'static', 'dynamic', 'guided', 'work_stealing'.");
+    return SCHEDULE_DYNAMIC;
+  }
+
+  std::string to_string(ThreadSchedule s) {
+    switch (s) {
+      case SCHEDULE_STATIC: return "static";
+      case SCHEDULE_DYNAMIC: return "dynamic";
+      case SCHEDULE_GUIDED: return "guided";
+      case SCHEDULE_WORK_STEALING: return "work_stealing";
+    }
+    return "";
+  }
+
+  casadi_int ThreadPool::default_chunk(ThreadSchedule schedule, casadi_int n,
+      casadi_int n_threads) {
+    switch (schedule) {
+      case SCHEDULE_STATIC:
+        // One contiguous block per thread
+        return std::max((n + n_threads - 1)/n_threads, casadi_int(1));
+      case SCHEDULE_DYNAMIC:
+        // A few chunks per thread
+        return std::max(n/(4*n_threads), casadi_int(1));
+      default:
+        return 1;
+    }
+  }
+
+  ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+#ifdef CASADI_WITH_THREAD
+  ThreadPool::ThreadPool() : task_(nullptr), n_(0), chunk_(1), max_threads_(1),
+    schedule_(SCHEDULE_DYNAMIC), stats_(nullptr), next_(0),
+    generation_(0), n_busy_(0), stop_(false), pid_(0) {
+#ifndef _WIN32
+    pid_ = getpid();
+#endif // _WIN32
+  }
+
+  bool ThreadPool::forked() const {
+#ifndef _WIN32
+    // Worker threads are not inherited by forked processes
+    return getpid()!=pid_;
+#else // _WIN32
+    return false;
+#endif // _WIN32
+  }
+
+  ThreadPool::~ThreadPool() {
+    resize(0);
+  }
+
+  casadi_int ThreadPool::size() {
+    casadi_int n = GlobalOptions::max_num_threads;
+    if (n<=0) n = std::thread::hardware_concurrency();
+    return std::max(n, casadi_int(1));
+  }
+
+  bool ThreadPool::active() {
+    return thread_pool_active;
+  }
+
+  void ThreadPool::resize(casadi_int n_workers) {
+    if (blocks_ && n_workers==static_cast<casadi_int>(workers_.size())) return;
+    // Stop all workers
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cv_start_.notify_all();
+    for (auto&& w : workers_) w.join();
+    workers_.clear();
+    stop_ = false;
+    blocks_.reset(new Block[n_workers+1]);
+    // Start new workers, thread 0 is the calling thread
+    for (casadi_int i=0; i<n_workers; ++i) {
+      workers_.emplace_back(&ThreadPool::work, this, i+1, generation_);
+    }
+  }
+
+  void ThreadPool::work(casadi_int thread, casadi_int generation) {
+    ThreadPoolActive a;
+    while (true) {
+      // Wait for a new job
+      {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_start_.wait(lock, [&]() { return stop_ || generation_!=generation; });
+        if (stop_) return;
+        generation = generation_;
+      }
+      // Contribute to the job
+      if (thread<max_threads_) process(thread);
+      // Signal completion
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (--n_busy_==0) cv_done_.notify_one();
+    }
+  }
+
+  bool ThreadPool::next_range(casadi_int thread, casadi_int& i0, casadi_int& i1) {
+    switch (schedule_) {
+      case SCHEDULE_STATIC:
+        // Chunks thread, thread + max_threads, ..., i0 holds the previous chunk
+        i0 = i0<0 ? thread*chunk_ : i0 + max_threads_*chunk_;
+        break;
+      case SCHEDULE_DYNAMIC:
+        i0 = next_.fetch_add(chunk_);
+        break;
+      case SCHEDULE_GUIDED:
+        {
+          // Chunk proportional to the remaining work
+          i0 = next_.load();
+          casadi_int sz;
+          do {
+            if (i0>=n_) return false;
+            sz = std::max((n_ - i0)/(2*max_threads_), chunk_);
+          } while (!next_.compare_exchange_weak(i0, i0 + sz));
+          i1 = std::min(i0 + sz, n_);
+          return true;
+        }
+      case SCHEDULE_WORK_STEALING:
+        {
+          // Take from the front of the own block
+          Block& b = blocks_[thread];
+          i0 = -1;
+          {
+            std::lock_guard<std::mutex> lock(b.mtx);
+            if (b.begin<b.end) {
+              i0 = b.begin;
+              i1 = b.begin = std::min(b.begin + chunk_, b.end);
+              return true;
+            }
+          }
+          // Steal the back half of the block of another thread
+          for (casadi_int k=1; k<max_threads_; ++k) {
+            Block& v = blocks_[(thread + k) % max_threads_];
+            std::lock_guard<std::mutex> lock(v.mtx);
+            if (v.begin<v.end) {
+              i0 = v.begin + (v.end - v.begin)/2;
+              i1 = v.end;
+              v.end = i0;
+              break;
+            }
+          }
+          if (i0<0) return false;
+          // Keep the rest of the stolen range as the own block
+          std::lock_guard<std::mutex> lock(b.mtx);
+          b.begin = std::min(i0 + chunk_, i1);
+          b.end = i1;
+          i1 = b.begin;
+          return true;
+        }
+    }
+    if (i0>=n_) return false;
+    i1 = std::min(i0 + chunk_, n_);
+    return true;
+  }
+
+  void ThreadPool::process(casadi_int thread) {
+    auto t_start = std::chrono::steady_clock::now();
+    casadi_int i0 = -1, i1, n_iter = 0;
+    while (next_range(thread, i0, i1)) {
+      for (casadi_int i=i0; i<i1; ++i) (*task_)(i, thread);
+      n_iter += i1 - i0;
+    }
+    if (stats_) {
+      stats_->n_iter[thread] = n_iter;
+      stats_->t_wall[thread] = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t_start).count();
+    }
+  }
+
+  void ThreadPool::run(casadi_int n, casadi_int chunk, const Task& task,
+      casadi_int max_threads, ThreadSchedule schedule, ThreadPoolStats* stats) {
+    // Evaluate serially if nested, trivial, in a forked process or if the pool is in use
+    std::unique_lock<std::mutex> run_lock(run_mtx_, std::defer_lock);
+    if (n<=1 || max_threads==1 || active() || forked() || !run_lock.try_lock()) {
+      auto t_start = std::chrono::steady_clock::now();
+      for (casadi_int i=0; i<n; ++i) task(i, 0);
+      if (stats) {
+        stats->n_iter.assign(1, n);
+        stats->t_wall.assign(1, std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - t_start).count());
+      }
+      return;
+    }
+    // Adapt the number of workers to the current setting
+    casadi_int nt = size();
+    resize(nt-1);
+    if (max_threads>0) nt = std::min(nt, max_threads);
+    nt = std::min(nt, n);
+    if (nt==1) {
+      run_lock.unlock();
+      return run(n, chunk, task, 1, schedule, stats);
+    }
+    // Default chunk size
+    if (chunk<=0) chunk = default_chunk(schedule, n, nt);
+    // Statistics
+    if (stats) {
+      stats->n_iter.assign(nt, 0);
+      stats->t_wall.assign(nt, 0);
+    }
+    // Publish job
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      task_ = &task;
+      n_ = n;
+      chunk_ = chunk;
+      max_threads_ = nt;
+      schedule_ = schedule;
+      stats_ = stats;
+      for (casadi_int t=0; t<nt; ++t) {
+        blocks_[t].begin = t*n/nt;
+        blocks_[t].end = (t+1)*n/nt;
+      }
+      next_ = 0;
+      n_busy_ = workers_.size();
+      generation_++;
+    }
+    cv_start_.notify_all();
+    // Contribute from the calling thread
+    {
+      ThreadPoolActive a;
+      process(0);
+    }
+    // Wait for the workers to finish
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_done_.wait(lock, [&]() { return n_busy_==0; });
+    task_ = nullptr;
+    stats_ = nullptr;
+  }
+#else // CASADI_WITH_THREAD
+  ThreadPool::ThreadPool() {
+  }
+
+  ThreadPool::~ThreadPool() {
+  }
+
+  casadi_int ThreadPool::size() {
+    return 1;
+  }
+
+  bool ThreadPool::active() {
+    return false;
+  }
+
+  void ThreadPool::run(casadi_int n, casadi_int chunk, const Task& task,
+      casadi_int max_threads, ThreadSchedule schedule, ThreadPoolStats* stats) {
+    auto t_start = std::chrono::steady_clock::now();
+    for (casadi_int i=0; i<n; ++i) task(i, 0);
+    if (stats) {
+      stats->n_iter.assign(1, n);
+      stats->t_wall.assign(1, std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t_start).count());
+    }
+  }
+#endif // CASADI_WITH_THREAD
+
+} // namespace casadi
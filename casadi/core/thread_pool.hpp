@@ -0,0 +1,172 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_THREAD_POOL_HPP
+#define CASADI_THREAD_POOL_HPP
+
+#include "casadi_common.hpp"
+#include <functional>
+#include <memory>
+
+#ifdef CASADI_WITH_THREAD
+#include <atomic>
+#ifdef CASADI_WITH_THREAD_MINGW
+#include <mingw.thread.h>
+#include <mingw.mutex.h>
+#include <mingw.condition_variable.h>
+#else // CASADI_WITH_THREAD_MINGW
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif // CASADI_WITH_THREAD_MINGW
+#endif // CASADI_WITH_THREAD
+
+/// \cond INTERNAL
+namespace casadi {
+
+  /// Distribution of iterations among the threads of a ThreadPool
+  enum ThreadSchedule {
+    // Chunks assigned round-robin up front
+    SCHEDULE_STATIC,
+    // Chunks of fixed size taken from a shared counter
+    SCHEDULE_DYNAMIC,
+    // Like dynamic, with chunks shrinking as the remaining work decreases
+    SCHEDULE_GUIDED,
+    // Contiguous blocks per thread, idle threads steal half of another thread's block
+    SCHEDULE_WORK_STEALING
+  };
+
+  /// Convert a string to a ThreadSchedule
+  CASADI_EXPORT ThreadSchedule to_schedule(const std::string& s);
+
+  /// Convert a ThreadSchedule to a string
+  CASADI_EXPORT std::string to_string(ThreadSchedule s);
+
+  /// Per-thread statistics of a ThreadPool::run call
+  struct CASADI_EXPORT ThreadPoolStats {
+    // Number of iterations evaluated by each thread
+    std::vector<casadi_int> n_iter;
+    // Wall time spent by each thread on the job
+    std::vector<double> t_wall;
+  };
+
+  /** \brief Process-wide pool of persistent worker threads
+
+      Used for parallel evaluation, e.g. by ThreadMap. The number of threads,
+      including the calling thread, is given by GlobalOptions::max_num_threads
+      (0: hardware concurrency). Iterations are distributed in chunks.
+      Calls made from within a running task (nested parallelism), while the
+      pool is busy with another caller or from a forked child process are
+      evaluated serially on the calling thread.
+  */
+  class CASADI_EXPORT ThreadPool {
+  public:
+    /// Work item: iteration index and index of the executing thread
+    typedef std::function<void(casadi_int i, casadi_int thread)> Task;
+
+    /// Get the process-wide instance
+    static ThreadPool& instance();
+
+    /// Destructor, stops the workers
+    ~ThreadPool();
+
+    /// Number of threads, including the calling thread
+    static casadi_int size();
+
+    /** \brief Evaluate task(i, thread) for i = 0, ..., n-1, blocking
+        \param chunk Number of consecutive iterations handed out at once (0: automatic),
+               the minimum chunk size for guided scheduling
+        \param max_threads Only threads 0, ..., max_threads-1 take part (0: all)
+        \param stats If not null, per-thread statistics are written here
+        The task must not throw. */
+    void run(casadi_int n, casadi_int chunk, const Task& task, casadi_int max_threads=0,
+             ThreadSchedule schedule=SCHEDULE_DYNAMIC, ThreadPoolStats* stats=nullptr);
+
+    /// Is the calling thread currently executing a task of the pool?
+    static bool active();
+
+    /// Chunk size used when none is specified
+    static casadi_int default_chunk(ThreadSchedule schedule, casadi_int n, casadi_int n_threads);
+
+  private:
+    /// Constructor, use instance()
+    ThreadPool();
+
+#ifdef CASADI_WITH_THREAD
+    // Change the number of worker threads (calling thread excluded)
+    void resize(casadi_int n_workers);
+
+    // Main loop of a worker thread
+    void work(casadi_int thread, casadi_int generation);
+
+    // Process chunks of the current job until all are handed out
+    void process(casadi_int thread);
+
+    // Is this a process forked after the pool was created?
+    bool forked() const;
+
+    // Get the next range of iterations [i0, i1) for a thread, false if done
+    bool next_range(casadi_int thread, casadi_int& i0, casadi_int& i1);
+
+    // Remaining block of a thread, for work stealing
+    struct Block {
+      std::mutex mtx;
+      casadi_int begin, end;
+    };
+
+    // Worker threads
+    std::vector<std::thread> workers_;
+
+    // Held by the thread submitting a job
+    std::mutex run_mtx_;
+
+    // Protects the job state below
+    std::mutex mtx_;
+    std::condition_variable cv_start_, cv_done_;
+
+    // Current job
+    const Task* task_;
+    casadi_int n_, chunk_, max_threads_;
+    ThreadSchedule schedule_;
+    ThreadPoolStats* stats_;
+    std::atomic<casadi_int> next_;
+
+    // Blocks for work stealing, one per thread
+    std::unique_ptr<Block[]> blocks_;
+
+    // Job counter, number of workers still busy with the job, termination flag
+    casadi_int generation_, n_busy_;
+    bool stop_;
+
+    // Process that created the pool
+    casadi_int pid_;
+#endif // CASADI_WITH_THREAD
+  };
+
+} // namespace casadi
+/// \endcond
+
+#endif // CASADI_THREAD_POOL_HPP
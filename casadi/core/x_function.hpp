@@ -435,6 +435,13 @@ namespace casadi {
       // Additions to the jacobian matrix
       std::vector<casadi_int> adds, adds2;
 
+      // Compressed sensitivities, the first entry is a zero for unassigned nonzeros
+      std::vector<MatType> sens(1, MatType::zeros(1, 1));
+      casadi_int sens_nnz = 1;
+
+      // Decompression map: Jacobian nonzero -> entry in the compressed sensitivities
+      std::vector<casadi_int> jmap(ret.nnz(), 0);
+
       // Temporary vector
       std::vector<casadi_int> tmp;
 
@@ -642,37 +649,17 @@ namespace casadi {
             }
           }
 
-          // Get entries in fsens[d][oind] with nonnegative indices
-          tmp.resize(adds.size());
-          casadi_int sz = 0;
+          // Add contribution to the decompression map
           for (casadi_int i=0; i<adds.size(); ++i) {
-            if (adds[i]>=0) {
-              adds[sz] = adds[i];
-              tmp[sz++] = i;
-            }
+            if (adds[i]>=0) jmap[adds[i]] = sens_nnz + i;
           }
-          adds.resize(sz);
-          tmp.resize(sz);
-
-          // Add contribution to the Jacobian
-          ret.nz(adds) = fsens[d][oind].nz(tmp);
-
           if (symmetric) {
-            // Get entries in fsens[d][oind] with nonnegative indices
-            tmp.resize(adds2.size());
-            sz = 0;
             for (casadi_int i=0; i<adds2.size(); ++i) {
-              if (adds2[i]>=0) {
-                adds2[sz] = adds2[i];
-                tmp[sz++] = i;
-              }
+              if (adds2[i]>=0) jmap[adds2[i]] = sens_nnz + i;
             }
-            adds2.resize(sz);
-            tmp.resize(sz);
-
-            // Add contribution to the Jacobian
-            ret.nz(adds2) = fsens[d][oind].nz(tmp);
           }
+          sens.push_back(vec(fsens[d][oind]));
+          sens_nnz += fsens[d][oind].nnz();
         }
 
         // Add elements to the Jacobian matrix
@@ -702,10 +689,12 @@ namespace casadi {
               casadi_int anz = nzmap[inz];
               if (anz<0) continue;
 
-              // Get the input seed
-              ret.nz(elJ) = asens[d][iind].nz(anz);
+              // Add contribution to the decompression map
+              jmap[elJ] = sens_nnz + anz;
             }
           }
+          sens.push_back(vec(asens[d][iind]));
+          sens_nnz += asens[d][iind].nnz();
         }
 
         // Update direction offsets
@@ -713,6 +702,11 @@ namespace casadi {
         offset_nadir += nadir_batch;
       }
 
+      // Decompress all Jacobian nonzeros in a single gather operation
+      if (verbose_) casadi_message("jac decompression");
+      MatType jac_nz = vertcat(sens).nz(jmap);
+      ret = MatType(ret.sparsity(), jac_nz);
+
       // Return
       return ret.T();
     } catch (std::exception& e) {
@@ -42,8 +42,12 @@ extern "C" {
 
 /* Integer type */
 #ifndef casadi_int
+#ifdef CASADI_INT32
+#define casadi_int int
+#else
 #define casadi_int long long int
 #endif
+#endif
 
 /* Function types corresponding to entry points in CasADi's C API */
 typedef void (*casadi_signal_t)(void);
@@ -160,7 +160,7 @@ namespace casadi {
     // Place in block to avoid conflicts caused by local variables
     g << "{\n";
     g.comment("FIXME(@jaeandersson): Memory allocation can be avoided");
-    g << "casadi_real lt[" << sp_Lt_.nnz() << "], "
+    g << g.solve_real() << " lt[" << sp_Lt_.nnz() << "], "
          "d[" << nrow() << "], "
          "w[" << nrow() << "];\n";
 
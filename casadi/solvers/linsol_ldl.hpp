@@ -89,6 +89,7 @@ namespace casadi {
     /// Generate C code
     void generate(CodeGenerator& g, const std::string& A, const std::string& x,
                   casadi_int nrhs, bool tr) const override;
+    bool has_codegen_mixed() const override { return true;}
 
     /// Number of negative eigenvalues
     casadi_int neig(void* mem, const double* A) const override;
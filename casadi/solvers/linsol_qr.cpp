@@ -136,8 +136,10 @@ namespace casadi {
     nullity = casadi_qr_singular(&rmin, &irmin, get_ptr(m->r), sp_r_, get_ptr(pc_), eps_);
     if (nullity) {
       if (verbose_) {
-        print("Singularity detected: Rank %lld<%lld\n", ncol()-nullity, ncol());
-        print("First singular R entry: %g<%g, corresponding to row %lld\n", rmin, eps_, irmin);
+        print("Singularity detected: Rank %lld<%lld\n",
+          static_cast<long long>(ncol()-nullity), static_cast<long long>(ncol()));
+        print("First singular R entry: %g<%g, corresponding to row %lld\n",
+          rmin, eps_, static_cast<long long>(irmin));
         casadi_qr_colcomb(get_ptr(m->w), get_ptr(m->r), sp_r_, get_ptr(pc_), eps_, 0);
         print("Linear combination of columns:\n[");
         for (casadi_int k=0; k<ncol(); ++k) print(k==0 ? "%g" : ", %g", m->w[k]);
@@ -175,12 +177,14 @@ namespace casadi {
     // Place in block to avoid conflicts caused by local variables
     g << "{\n";
     g.comment("FIXME(@jaeandersson): Memory allocation can be avoided");
-    g << "casadi_real v[" << sp_v_.nnz() << "], "
+    g << g.solve_real() << " v[" << sp_v_.nnz() << "], "
          "r[" << sp_r_.nnz() << "], "
          "beta[" << ncol() << "], "
          "w[" << nrow() + ncol() << "];\n";
 
     if (n_cache_) {
+      casadi_assert(g.solve_real()=="casadi_real",
+        "Option 'cache' not supported with mixed precision code generation");
       g << "casadi_real *c;\n";
       g << "casadi_real cache[" << cache_stride_*n_cache_ << "];\n";
       g << "int cache_loc[" << n_cache_ << "] = {";
@@ -96,6 +96,7 @@ namespace casadi {
     /// Generate C code
     void generate(CodeGenerator& g, const std::string& A, const std::string& x,
                   casadi_int nrhs, bool tr) const override;
+    bool has_codegen_mixed() const override { return true;}
 
     // Get name of the plugin
     const char* plugin_name() const override { return "qr";}
@@ -35,6 +35,19 @@
 #endif // OBJECT_FILE_SUFFIX
 
 #include <cstdlib>
+#include <cstdint>
+#include <iomanip>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <sys/utime.h>
+#else // _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif // _WIN32
 
 using namespace std;
 namespace casadi {
@@ -69,8 +82,11 @@ namespace casadi {
 #endif // _WIN32
 
     if (cleanup_) {
-      if (remove(bin_name_.c_str())) casadi_warning("Failed to remove " + bin_name_);
-      if (remove(obj_name_.c_str())) casadi_warning("Failed to remove " + obj_name_);
+      // Libraries in the cache outlive the importer, objects are removed after linking
+      if (cache_.empty()) {
+        if (remove(bin_name_.c_str())) casadi_warning("Failed to remove " + bin_name_);
+        if (remove(obj_name_.c_str())) casadi_warning("Failed to remove " + obj_name_);
+      }
       for (const std::string& s : extra_suffixes_) {
         std::string name = base_name_+s;
         remove(name.c_str());
@@ -131,6 +147,17 @@ namespace casadi {
         "This is desired for thread-safety. "
         "This behaviour may defeat caching compiler wrappers. "
         "Default: true"}},
+      {"cache",
+       {OT_STRING,
+        "Directory of a persistent compilation cache, which may be shared between processes. "
+        "Libraries are keyed by a hash of the source file, the compiler and linker commands "
+        "and the CasADi version; a hit is loaded without compiling. "
+        "Files included by the source are not part of the key. "
+        "Default: no cache"}},
+      {"cache_size",
+       {OT_INT,
+        "Maximum number of libraries kept in the cache, "
+        "least recently used ones are removed. Default: 256"}},
      }
   };
 
@@ -141,6 +168,7 @@ namespace casadi {
     // Default options
 
     cleanup_ = true;
+    cache_size_ = 256;
     bool temp_suffix = true;
     std::string bare_name = "tmp_casadi_compiler_shell";
 
@@ -191,7 +219,42 @@ namespace casadi {
         bare_name = op.second.to_string();
       } else if (op.first=="temp_suffix") {
         temp_suffix = op.second;
+      } else if (op.first=="cache") {
+        cache_ = op.second.to_string();
+      } else if (op.first=="cache_size") {
+        cache_size_ = op.second;
+        casadi_assert(cache_size_>0, "Option 'cache_size' must be positive");
+      }
+    }
+
+    // Look up the library in the cache
+    std::string cached;
+    if (!cache_.empty()) {
+      std::vector<std::string> cmd = {compiler, compiler_setup, compiler_output_flag,
+                                      linker, linker_setup, linker_output_flag};
+      cmd.insert(cmd.end(), compiler_flags.begin(), compiler_flags.end());
+      cmd.push_back("");
+      cmd.insert(cmd.end(), linker_flags.begin(), linker_flags.end());
+      cached = cache_ + "/casadi_" + cache_key(cmd) + SHARED_LIBRARY_SUFFIX;
+      if (std::ifstream(cached).good()) {
+#ifdef _WIN32
+        handle_ = LoadLibrary(TEXT(cached.c_str()));
+#else // _WIN32
+        handle_ = dlopen(cached.c_str(), RTLD_LAZY);
+#endif // _WIN32
+        // May fail if evicted by another process in the meantime, then recompile
+        if (handle_) {
+          if (verbose_) casadi_message("Loaded " + cached + " from cache");
+          bin_name_ = cached;
+          cache_touch(cached);
+          return;
+        }
       }
+#ifdef _WIN32
+      _mkdir(cache_.c_str());
+#else // _WIN32
+      mkdir(cache_.c_str(), 0777);
+#endif // _WIN32
     }
 
     // Name of temporary file
@@ -201,7 +264,12 @@ namespace casadi {
       obj_name_ = bare_name + suffix;
     }
     base_name_ = std::string(obj_name_.begin(), obj_name_.begin()+obj_name_.size()-suffix.size());
-    bin_name_ = base_name_+SHARED_LIBRARY_SUFFIX;
+    if (cached.empty()) {
+      bin_name_ = base_name_+SHARED_LIBRARY_SUFFIX;
+    } else {
+      // Link in the cache directory, then rename to make the library visible atomically
+      bin_name_ = temporary_file(cache_ + "/casadi_tmp_", SHARED_LIBRARY_SUFFIX);
+    }
 
 #ifndef _WIN32
     // Have relative paths start with ./
@@ -253,6 +321,18 @@ namespace casadi {
       casadi_error("Linking failed. Tried \"" + ldcmd.str() + "\"");
     }
 
+    // Move into the cache, an identical library from a concurrent process may already be there
+    if (!cached.empty()) {
+      if (cleanup_) remove(obj_name_.c_str());
+      if (rename(bin_name_.c_str(), cached.c_str())) {
+        remove(bin_name_.c_str());
+        casadi_assert(std::ifstream(cached).good(), "Failed to add " + cached + " to cache");
+      }
+      bin_name_ = cached;
+      cache_touch(cached);
+      cache_evict();
+    }
+
 #ifdef _WIN32
     handle_ = LoadLibrary(TEXT(bin_name_.c_str()));
     SetDllDirectory(NULL);
@@ -271,6 +351,100 @@ namespace casadi {
 #endif // _WIN32
   }
 
+  std::string ShellCompiler::cache_key(const std::vector<std::string>& cmd) const {
+    // Source text
+    std::ifstream f(name_, std::ios::binary);
+    casadi_assert(f.good(), "Cannot read " + name_);
+    std::stringstream src;
+    src << f.rdbuf();
+
+    // 64-bit FNV-1a, stable across platforms and runs
+    uint64_t h = 14695981039346656037ULL;
+    auto add = [&h](const std::string& s) {
+      for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+      }
+      // Separator
+      h ^= 0xff;
+      h *= 1099511628211ULL;
+    };
+    add(CasadiMeta::version());
+    for (const std::string& c : cmd) add(c);
+    add(src.str());
+
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << h;
+    return ss.str();
+  }
+
+  void ShellCompiler::cache_touch(const std::string& path) {
+#ifdef _WIN32
+    _utime(path.c_str(), nullptr);
+#else // _WIN32
+    // File system timestamps of the current time are coarse, set a precise one
+    struct timespec ts[2];
+    clock_gettime(CLOCK_REALTIME, &ts[0]);
+    ts[1] = ts[0];
+    utimensat(AT_FDCWD, path.c_str(), ts, 0);
+#endif // _WIN32
+  }
+
+  void ShellCompiler::cache_evict() const {
+    // Cached libraries and their last use, in 100 ns (Windows) or ns units
+    std::vector<std::pair<int64_t, std::string> > entries;
+    std::string suffix = SHARED_LIBRARY_SUFFIX;
+    auto is_entry = [&suffix](const std::string& s) {
+      return s.size()>7+suffix.size() && s.compare(0, 7, "casadi_")==0
+        && s.compare(0, 11, "casadi_tmp_")!=0
+        && s.compare(s.size()-suffix.size(), suffix.size(), suffix)==0;
+    };
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA((cache_ + "/casadi_*").c_str(), &fd);
+    if (h==INVALID_HANDLE_VALUE) return;
+    do {
+      if (!is_entry(fd.cFileName)) continue;
+      ULARGE_INTEGER t;
+      t.LowPart = fd.ftLastWriteTime.dwLowDateTime;
+      t.HighPart = fd.ftLastWriteTime.dwHighDateTime;
+      entries.push_back(std::make_pair(static_cast<int64_t>(t.QuadPart),
+                                       cache_ + "/" + fd.cFileName));
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+#else // _WIN32
+    DIR* dir = opendir(cache_.c_str());
+    if (!dir) return;
+    while (struct dirent* e = readdir(dir)) {
+      if (!is_entry(e->d_name)) continue;
+      std::string path = cache_ + "/" + e->d_name;
+      struct stat st;
+      if (stat(path.c_str(), &st)) continue;
+#ifdef __APPLE__
+      const struct timespec& mt = st.st_mtimespec;
+#else // __APPLE__
+      const struct timespec& mt = st.st_mtim;
+#endif // __APPLE__
+      entries.push_back(std::make_pair(static_cast<int64_t>(mt.tv_sec)*1000000000
+                                       + mt.tv_nsec, path));
+    }
+    closedir(dir);
+#endif // _WIN32
+    casadi_int n_entries = entries.size();
+    if (n_entries<=cache_size_) return;
+
+    // Remove the least recently used, never the one just added
+    std::sort(entries.begin(), entries.end());
+    casadi_int n_remove = n_entries-cache_size_;
+    for (auto&& e : entries) {
+      if (n_remove==0) break;
+      if (e.second==bin_name_) continue;
+      if (verbose_) casadi_message("Evicting " + e.second + " from cache");
+      remove(e.second.c_str());
+      n_remove--;
+    }
+  }
+
   std::string ShellCompiler::library() const {
     return bin_name_;
   }
@@ -100,6 +100,21 @@ namespace casadi {
     /// Cleanup temporary files when unloading
     bool cleanup_;
 
+    /// Directory of the persistent compilation cache, empty if none
+    std::string cache_;
+
+    /// Maximum number of shared objects in the cache
+    casadi_int cache_size_;
+
+    /// Hash of everything that determines the compiled library
+    std::string cache_key(const std::vector<std::string>& cmd) const;
+
+    /// Mark a cache entry as used now
+    static void cache_touch(const std::string& path);
+
+    /// Remove least recently used entries exceeding cache_size_
+    void cache_evict() const;
+
     // Shared library handle
     typedef DL_HANDLE_TYPE handle_t;
     handle_t handle_;
@@ -0,0 +1,155 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+Checkout and release of memory objects in code generated with the option "thread_safe",
+compiled both as C11 and as C++
+*/
+
+#include "casadi/casadi.hpp"
+#include "casadi/core/function_internal.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace casadi;
+using namespace std;
+
+// Maximum number of memory objects in the generated code
+const int max_num_threads = 64;
+
+// Function with a memory object in generated code, counting its evaluations
+class Counter : public FunctionInternal {
+public:
+  explicit Counter(const string& name) : FunctionInternal(name) {}
+  ~Counter() override { clear_mem();}
+  string class_name() const override { return "Counter";}
+  size_t get_n_in() override { return 1;}
+  size_t get_n_out() override { return 2;}
+  Sparsity get_sparsity_in(casadi_int i) override { return Sparsity::scalar();}
+  Sparsity get_sparsity_out(casadi_int i) override { return Sparsity::scalar();}
+  bool has_codegen() const override { return true;}
+  string codegen_mem_type() const override { return "casadi_real";}
+  void codegen_init_mem(CodeGenerator& g) const override {
+    g.add_include("stdlib.h");
+    g << codegen_mem(g) << " = (casadi_real*) malloc(sizeof(casadi_real));\n"
+      << "if (!" << codegen_mem(g) << ") return 1;\n"
+      << "*" << codegen_mem(g) << " = 0;\n"
+      << "return 0;\n";
+  }
+  void codegen_free_mem(CodeGenerator& g) const override {
+    g << "free(" << codegen_mem(g) << ");\n";
+  }
+  void codegen_body(CodeGenerator& g) const override {
+    // First output doubles the input, second counts the calls with the memory object
+    g << "*" << codegen_mem(g) << " += 1;\n"
+      << "if (res[0]) res[0][0] = arg[0] ? 2*arg[0][0] : 0;\n"
+      << "if (res[1]) res[1][0] = *" << codegen_mem(g) << ";\n";
+  }
+};
+
+// Signatures of the generated functions
+typedef int (*checkout_t)(void);
+typedef void (*release_t)(int);
+typedef int (*eval_t)(const double**, double**, long long int*, double*, int);
+
+void test_library(Importer lib) {
+  checkout_t checkout = reinterpret_cast<checkout_t>(lib.get_function("counter_checkout"));
+  release_t release = reinterpret_cast<release_t>(lib.get_function("counter_release"));
+  eval_t eval = reinterpret_cast<eval_t>(lib.get_function("counter"));
+  casadi_assert(checkout && release && eval, "Symbols missing");
+
+  // Sequential calls reuse the released memory object
+  for (int k=1; k<=3; ++k) {
+    int mem = checkout();
+    casadi_assert(mem==0, "Memory object not reused");
+    double x = 1, y = 0, n = 0;
+    const double* arg[] = {&x};
+    double* res[] = {&y, &n};
+    casadi_assert(eval(arg, res, nullptr, nullptr, mem)==0, "Evaluation failed");
+    casadi_assert(y==2 && n==k, "Wrong result");
+    release(mem);
+  }
+
+  // Concurrent calls never share a memory object
+  int n_threads = 4, n_calls = 10000;
+  vector<atomic<int> > in_use(max_num_threads);
+  for (auto&& u : in_use) u = 0;
+  atomic<int> n_failed(0);
+  vector<thread> threads;
+  for (int t=0; t<n_threads; ++t) {
+    threads.emplace_back([&]() {
+      for (int k=0; k<n_calls; ++k) {
+        int mem = checkout();
+        if (mem<0 || mem>=max_num_threads || in_use[mem].exchange(1)) {
+          n_failed++;
+          return;
+        }
+        double x = k, y = 0, n = 0;
+        const double* arg[] = {&x};
+        double* res[] = {&y, &n};
+        if (eval(arg, res, nullptr, nullptr, mem) || y!=2*k) n_failed++;
+        in_use[mem] = 0;
+        release(mem);
+      }
+    });
+  }
+  for (thread& th : threads) th.join();
+  casadi_assert(n_failed==0, "Concurrent checkout failed");
+
+  // Every call was counted exactly once
+  double n_total = 0;
+  for (int mem=0; mem<max_num_threads; ++mem) {
+    int m = checkout();
+    if (m<0) break;
+    double x = 0, y = 0, n = 0;
+    const double* arg[] = {&x};
+    double* res[] = {&y, &n};
+    eval(arg, res, nullptr, nullptr, m);
+    n_total += n - 1;
+  }
+  casadi_assert(n_total == 3 + n_threads*n_calls, "Calls not counted exactly once");
+}
+
+int main(int argc, char *argv[])
+{
+  Function f = Function::create(new Counter("counter"), Dict());
+
+  // Generate with atomic checkout/release
+  CodeGenerator gen("counter_thread_safe.c", {{"thread_safe", true}});
+  gen.add(f);
+  string src = gen.generate();
+
+  // C11 atomics
+  string max_threads = "-DCASADI_MAX_NUM_THREADS=" + str(max_num_threads);
+  test_library(Importer(src, "shell", {{"name", "counter_c11"},
+    {"compiler_flags", vector<string>{"-std=c11", "-pthread", max_threads}}}));
+
+  // C++ atomics
+  test_library(Importer(src, "shell", {{"name", "counter_cpp"},
+    {"compiler", "g++"}, {"linker", "g++"},
+    {"compiler_flags", vector<string>{"-x", "c++", "-std=c++11", "-pthread", max_threads}}}));
+
+  cout << "Thread-safe code generation tests passed" << endl;
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+Numerical evaluation of Functions with DM, reusing work vectors and memory objects
+*/
+
+#include "casadi/casadi.hpp"
+#include <thread>
+
+using namespace casadi;
+using namespace std;
+
+// Function that returns the first output of another Function, evaluated with DM
+class Nested : public Callback {
+public:
+  Nested(const Function& f) : f_(f) { construct("nested"); }
+  casadi_int get_n_in() override { return 1;}
+  casadi_int get_n_out() override { return 1;}
+  Sparsity get_sparsity_in(casadi_int i) override { return f_.sparsity_in(0);}
+  Sparsity get_sparsity_out(casadi_int i) override { return f_.sparsity_out(0);}
+  vector<DM> eval(const vector<DM>& arg) const override {
+    return {f_(arg).at(0)};
+  }
+  Function f_;
+};
+
+int main(int argc, char *argv[])
+{
+  SX x = SX::sym("x", 2);
+  Function f("f", {x}, {2*x, sum1(x)});
+  casadi_int n_mem = f.stats().at("n_mem");
+
+  // Outputs with matching sparsity are written in place
+  vector<DM> res = {DM::zeros(2, 1), DM::zeros(1, 1)};
+  const double* res0 = get_ptr(res[0].nonzeros());
+  const double* res1 = get_ptr(res[1].nonzeros());
+  for (casadi_int k=0; k<10; ++k) {
+    f.call(vector<DM>{DM(vector<double>{1, double(k)})}, res);
+    casadi_assert(res[0].nonzeros() == vector<double>({2, 2.0*k}), "Wrong result");
+    casadi_assert(res[1].scalar() == 1 + k, "Wrong result");
+    casadi_assert(get_ptr(res[0].nonzeros()) == res0 && get_ptr(res[1].nonzeros()) == res1,
+      "Output not reused in place");
+  }
+
+  // The same memory object is reused by repeated calls
+  casadi_assert(f.stats().at("n_mem").as_int() <= n_mem + 1, "Memory object not reused");
+
+  // Evaluation uses the memory object reported by stats()
+  Function f_timed("f_timed", {x}, {2*x}, Dict{{"record_time", true}});
+  for (casadi_int k=0; k<3; ++k) f_timed(vector<DM>{DM(vector<double>{1, 2})});
+  casadi_assert(f_timed.stats().at("n_call_total").as_int() == 1, "Call not recorded");
+
+  // Outputs with mismatching sparsity are reallocated, inputs projected
+  res = {DM::zeros(3, 1), DM()};
+  f.call(vector<DM>{DM(Sparsity::dense(2, 1), 3)}, res);
+  casadi_assert(res[0].sparsity() == Sparsity::dense(2, 1), "Output not reallocated");
+  casadi_assert(res[0].nonzeros() == vector<double>({6, 6}), "Wrong result");
+  f.call(vector<DM>{DM(Sparsity::triplet(2, 1, {1}, {0}), 3)}, res);
+  casadi_assert(res[0].nonzeros() == vector<double>({0, 6}), "Wrong result with projection");
+
+  // Recursive evaluation, each level checks out its own memory object
+  Nested g_cb(f);
+  Function g = g_cb;
+  Nested h_cb(g);
+  Function h = h_cb;
+  casadi_assert(h(vector<DM>{DM(vector<double>{1, 2})}).at(0).nonzeros()
+    == vector<double>({2, 4}), "Wrong nested result");
+  res = {DM::zeros(2, 1)};
+  for (casadi_int k=0; k<10; ++k) h.call(vector<DM>{DM(vector<double>{1, 2})}, res);
+  casadi_assert(res[0].nonzeros() == vector<double>({2, 4}), "Wrong nested result");
+
+  // Concurrent calls from threads
+  casadi_int n_threads = 4, n_calls = 1000;
+  n_mem = f.stats().at("n_mem");
+  vector<int> failed(n_threads, 0);
+  vector<thread> threads;
+  for (casadi_int t=0; t<n_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      vector<DM> r = {DM::zeros(2, 1), DM::zeros(1, 1)};
+      for (casadi_int k=0; k<n_calls; ++k) {
+        vector<DM> a = {DM(vector<double>{double(t), double(k)})};
+        // Alternate between direct and nested calls
+        if (k % 2) {
+          f.call(a, r);
+        } else {
+          g.call(a, r);
+        }
+        if (r[0].nonzeros() != vector<double>({2.0*t, 2.0*k})) failed[t] = 1;
+      }
+    });
+  }
+  for (thread& th : threads) th.join();
+  for (casadi_int t=0; t<n_threads; ++t) casadi_assert(!failed[t], "Wrong concurrent result");
+
+  // At most one memory object per thread and recursion level
+  casadi_assert(f.stats().at("n_mem").as_int() <= n_mem + 2*n_threads,
+    "Memory objects not reused between calls");
+
+  cout << "Function call tests passed" << endl;
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+Asynchronous evaluation of Functions with FunctionFuture
+*/
+
+#include "casadi/casadi.hpp"
+#include <atomic>
+
+using namespace casadi;
+using namespace std;
+
+// Function whose evaluation always fails
+class Failing : public Callback {
+public:
+  Failing() { construct("failing"); }
+  casadi_int get_n_in() override { return 1;}
+  casadi_int get_n_out() override { return 1;}
+  vector<DM> eval(const vector<DM>& arg) const override {
+    casadi_error("Failing evaluation");
+  }
+};
+
+int main(int argc, char *argv[])
+{
+  SX x = SX::sym("x", 2);
+  Function f("f", {x}, {2*x});
+  Function g("g", {x}, {x + 1});
+  SX y = SX::sym("y", 2);
+  Function h("h", {x, y}, {dot(x, y)});
+
+  // Single evaluation
+  FunctionFuture a = f.call_async({DM(vector<double>{1, 2})});
+  casadi_assert(a.success(), "Evaluation failed: " + a.error());
+  casadi_assert(a.ready(), "Not ready after completion");
+  casadi_assert(a.get().at(0).nonzeros() == vector<double>({2, 4}), "Wrong result");
+
+  // Chaining, outputs of f are inputs of g, then of f again
+  std::atomic<int> n_called(0);
+  FunctionFuture::Callback count = [&n_called](const FunctionFuture& r) { n_called++;};
+  FunctionFuture b = f.call_async({DM(vector<double>{1, 2})}).then(g, count).then(f, count);
+  casadi_assert(b.get().at(0).nonzeros() == vector<double>({6, 10}), "Wrong chained result");
+
+  // A callback has completed before dependent evaluations start
+  casadi_assert(n_called >= 1, "Completion callback not invoked before dependent");
+  b.then(g).wait();
+  casadi_assert(n_called == 2, "Completion callback not invoked");
+
+  // Dependencies, h runs once both inputs are available
+  FunctionFuture c1 = f.call_async({DM(vector<double>{1, 2})});
+  FunctionFuture c2 = g.call_async({DM(vector<double>{3, 4})});
+  vector<DM> h_arg(2);
+  FunctionFuture c = c1.then(g, [&](const FunctionFuture& r) { h_arg[0] = r.get().at(0);});
+  FunctionFuture d = c2.then(f, [&](const FunctionFuture& r) { h_arg[1] = r.get().at(0);});
+  vector<double> h_in0(2), h_in1(2), h_out(1);
+  const double* h_argp[] = {get_ptr(h_in0), get_ptr(h_in1)};
+  double* h_resp[] = {get_ptr(h_out)};
+  FunctionFuture e = f.call_async({DM(vector<double>{0, 0})}, {c, d},
+    [&](const FunctionFuture& r) {
+      // Dependencies completed, including their callbacks
+      h_in0 = h_arg[0].nonzeros();
+      h_in1 = h_arg[1].nonzeros();
+    });
+  e.wait();
+  casadi_assert(h_in0 == vector<double>({3, 5}), "Dependency not completed");
+  casadi_assert(h_in1 == vector<double>({8, 10}), "Dependency not completed");
+  FunctionFuture k = h.call_async(h_argp, h_resp);
+  k.wait();
+  casadi_assert(k.success() && h_out[0] == 3*8 + 5*10, "Wrong result with raw buffers");
+
+  // Exceptions propagate through get()
+  Failing failing_cb;
+  Function failing = failing_cb;
+  FunctionFuture fail = failing.call_async({DM(1)});
+  casadi_assert(!fail.success(), "Expected failure");
+  casadi_assert(fail.error().find("Failing evaluation") != string::npos,
+    "Unexpected error message: " + fail.error());
+  bool thrown = false;
+  try {
+    fail.get();
+  } catch (exception& ex) {
+    thrown = true;
+  }
+  casadi_assert(thrown, "get() did not throw");
+
+  // Evaluations after a failed one are skipped and fail too
+  n_called = 0;
+  FunctionFuture skipped = failing.call_async({DM(1)}).then(failing, count);
+  casadi_assert(!skipped.success(), "Expected failure of dependent");
+  casadi_assert(skipped.error().find("Dependency failed") != string::npos,
+    "Unexpected error message: " + skipped.error());
+  FunctionFuture after_failed = f.call_async({DM(vector<double>{1, 2})}, {fail});
+  casadi_assert(!after_failed.success(), "Expected failure after failed dependency");
+
+  // Chaining requires matching sparsities
+  thrown = false;
+  try {
+    a.then(h);
+  } catch (exception& ex) {
+    thrown = true;
+  }
+  casadi_assert(thrown, "Chaining with mismatching Function did not throw");
+
+  // Skipped evaluation still invokes its callback
+  skipped.then(failing).wait();
+  casadi_assert(n_called == 1, "Completion callback not invoked after failure");
+
+  cout << "FunctionFuture tests passed" << endl;
+  return 0;
+}
@@ -398,6 +398,45 @@ class ADtests(casadiTestCase):
     #print array(JT_out[0])
     #print array(H_out[0])
 
+  def test_hessian_edge_pushing(self):
+    self.message("Hessian via edge pushing")
+    x=SX.sym("x",5)
+    p=SX.sym("p")
+    e=x[0]*x[1]+sin(x[2])*x[3]**2+exp(x[4]*p)*x[0]+sqrt(x[1]**2+1)+x[3]/x[4]
+    f=Function("f",[x,p],[e],["x","p"],["e"])
+    h1=f.factory("h1",["x","p"],["hess:e:x:x","grad:e:x"])
+    h2=f.factory("h2",["x","p"],["hess:e:x:x","grad:e:x"],{"hessian_method":"edge_pushing"})
+    self.assertEqual(h1.sparsity_out(0).nnz(),h2.sparsity_out(0).nnz())
+    self.checkfunction_light(h1,h2,inputs=[[0.3,1.2,0.7,2.1,-0.4],0.7])
+
+    y=SX.sym("y",Sparsity.lower(3))
+    ey=sin(y[0,0]*y[2,1])+y[1,0]**2*y[2,2]
+    g=Function("g",[y],[ey],["y"],["e"])
+    H1=Function("H1",[y],[triu(jacobian(gradient(ey,y),y))])
+    H2=g.factory("H2",["y"],["hess:e:y:y"],{"hessian_method":"edge_pushing"})
+    self.checkfunction_light(H1,H2,inputs=[DM(Sparsity.lower(3),[0.1,0.2,0.3,0.4,0.5,0.6])])
+
+  def test_jac_parallelization(self):
+    self.message("Jacobian with parallel directional derivative batches")
+    x=SX.sym("x",12)
+    p=SX.sym("p",Sparsity.lower(2))
+    e=vertcat(*[sin(x[i])*x[(i+1)%12]*p[i%3]+x[(5*i)%12] for i in range(12)])
+    GlobalOptions.setMaxNumThreads(3)
+    for ad_weight in [0,1]:
+      opts={"max_num_dir":2,"ad_weight":ad_weight}
+      f1=Function("f",[x,p],[e,dot(x,x)],opts)
+      opts["jac_parallelization"]="thread"
+      f2=Function("f",[x,p],[e,dot(x,x)],opts)
+      J1=f1.jacobian()
+      J2=f2.jacobian()
+      self.assertTrue(J1.sparsity_out(0)==J2.sparsity_out(0))
+      X=DM(numpy.random.random(12))
+      P=DM(Sparsity.lower(2),[0.1,0.2,0.3])
+      self.checkfunction_light(J1,J2,inputs=[X,P]+f1(X,P))
+      f3=Function.deserialize(f2.serialize())
+      self.checkfunction_light(J1,f3.jacobian(),inputs=[X,P]+f1(X,P))
+    GlobalOptions.setMaxNumThreads(0)
+
   def test_bugshape(self):
     self.message("shape bug")
     x=SX.sym("x")
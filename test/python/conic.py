@@ -897,6 +897,15 @@ class ConicTests(casadiTestCase):
       if aux_options["codegen"]:
         self.check_codegen(solver,solver_in,std="c99",extralibs=extralibs,extra_options=aux_options["codegen"])
 
+  @requires_conic("osqp")
+  def test_osqp_codegen_thread_safe(self):
+    x=SX.sym("x")
+    qp={'x':x, 'f':(x-1)**2, 'g':vertcat(*[x,x,x])}
+    solver = qpsol("mysolver", "osqp", qp, {"osqp":{"alpha":1,"eps_abs":1e-8,"eps_rel":1e-8}})
+    solver_in = {"lbx":[-10],"ubx":[10],"lbg":[-10,-10,-10],"ubg":[10,10,10],"x0":[0]}
+    self.check_codegen(solver,solver_in,std="c11",extralibs=["osqp"],extra_options=[] if os.name=="nt" else ["-Wno-unused-variable"],
+      opts={"thread_safe":True},definitions=["CASADI_MAX_NUM_THREADS=4"])
+
   @requires_conic("hpmpc")
   @requires_conic("qpoases")
   def test_hpmpc(self):
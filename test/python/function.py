@@ -29,6 +29,7 @@ from types import *
 from helpers import *
 import pickle
 import os
+import itertools
 scipy_interpolate = False
 try:
   import scipy.interpolate
@@ -627,6 +628,159 @@ class Functiontests(casadiTestCase):
     self.checkfunction_light(fun.map(4,"thread",2),fun.map(4),inputs=[hcat(X_[:4]),hcat(Y_[:4]),hcat(Z_[:4]),hcat(V_[:4])])
     self.checkfunction_light(fun.map(4,"thread",5),fun.map(4),inputs=[hcat(X_[:4]),hcat(Y_[:4]),hcat(Z_[:4]),hcat(V_[:4])])
 
+  def test_map_thread_pool(self):
+    x = SX.sym("x",2)
+    fun = Function("f",[x],[sin(x)*x[0]])
+    X = DM(np.random.random((2,40)))
+    Y = DM(np.random.random((2,120)))
+    # Nested thread maps: inner map is evaluated serially by the pool worker
+    inner = fun.map(40,"thread")
+    y = MX.sym("y",2,40)
+    outer = Function("g",[y],[inner(y)]).map(3,"thread")
+    for n in [0,1,3]:
+      GlobalOptions.setMaxNumThreads(n)
+      self.checkfunction_light(inner,fun.map(40),inputs=[X])
+      self.checkfunction_light(outer,fun.map(120),inputs=[Y])
+    # Work memory scales with the number of threads, not the map count
+    GlobalOptions.setMaxNumThreads(2)
+    for parallelization in ["thread","openmp"]:
+      self.assertTrue(fun.map(1000,parallelization).sz_w()<=2*fun.sz_w())
+    GlobalOptions.setMaxNumThreads(0)
+
+  def test_memory_stats_concurrent(self):
+    import threading
+    x = SX.sym("x",2)
+    fun = Function("f",[x],[sin(x)*x[0]])
+    X = DM(numpy.random.random((2,40)))
+    ref = fun.map(40)(X)
+    GlobalOptions.setMaxNumThreads(4)
+    F = fun.map(40,"thread")
+    # Concurrent evaluation, by the thread map and from Python threads
+    failed = []
+    def work():
+      for k in range(20):
+        if k % 2:
+          r = F(X)
+        else:
+          r = horzcat(*[fun(X[:,i]) for i in range(40)])
+        if float(norm_inf(r-ref))>1e-12: failed.append(k)
+    threads = [threading.Thread(target=work) for i in range(4)]
+    for t in threads: t.start()
+    for t in threads: t.join()
+    self.assertFalse(failed)
+    stats = fun.stats()
+    n_mem = stats["n_mem"]
+    # At most one memory object per evaluating thread and the main thread,
+    # and the ones checked out by the thread map for each Python thread
+    self.assertTrue(n_mem>=1)
+    self.assertTrue(n_mem<=2+4+4*4)
+    self.assertTrue(stats["n_mem_contention"]>=0)
+    # Memory objects are reused, repeated evaluation does not allocate
+    contention = stats["n_mem_contention"]
+    for k in range(10):
+      F(X)
+      fun(X[:,0])
+    stats = fun.stats()
+    self.assertEqual(stats["n_mem"],n_mem)
+    self.assertTrue(stats["n_mem_contention"]>=contention)
+    GlobalOptions.setMaxNumThreads(0)
+
+  def test_map_schedule(self):
+    x = SX.sym("x")
+    y = x
+    for k in range(20):
+      y = sin(y)+x
+    fun = Function("f",[x],[y])
+    X = DM(np.random.random((1,17)))
+    GlobalOptions.setMaxNumThreads(3)
+    for parallelization in ["thread","openmp"]:
+      for schedule in ["static","dynamic","guided","work_stealing"]:
+        for chunk_size in [0,1,4]:
+          F = fun.map(17,parallelization,{"schedule":schedule,"chunk_size":chunk_size})
+          self.checkfunction_light(F,fun.map(17),inputs=[X])
+          if chunk_size==0:
+            self.check_codegen(F,inputs=[X],extra_options=None if os.name=='nt' else ["-fopenmp"])
+          F(X)
+          stats = F.stats()
+          if "n_iter_thread" in stats:
+            self.assertEqual(sum(stats["n_iter_thread"]),17)
+            self.assertEqual(len(stats["t_wall_thread"]),len(stats["n_iter_thread"]))
+    with self.assertInException("schedule"):
+      fun.map(17,"thread",{"schedule":"foo"})
+    GlobalOptions.setMaxNumThreads(0)
+
+  def test_map_deserialize_compat(self):
+    x = SX.sym("x",2)
+    fun = Function("f",[x],[sin(x)*x[0]])
+    X = DM(np.random.random((2,7)))
+    for parallelization in ["openmp","thread"]:
+      # Written before the thread count, schedule and chunk size were serialized
+      F = Function.load(os.path.join("..","data","map_%s_v1.casadi" % parallelization))
+      self.checkfunction_light(F,fun.map(7),inputs=[X])
+      # Current streams keep the schedule and chunk size
+      F = fun.map(7,parallelization,{"schedule":"dynamic","chunk_size":2})
+      F2 = Function.deserialize(F.serialize())
+      self.assertEqual(F2.serialize(),F.serialize())
+      self.checkfunction_light(F2,fun.map(7),inputs=[X])
+
+  def test_map_process(self):
+    x = SX.sym("x",2)
+    p = SX.sym("p")
+    fun = Function("f",[x,p],[sin(x)*p,sum1(x)])
+    X = DM(np.random.random((2,13)))
+    P = DM(np.random.random((1,13)))
+    GlobalOptions.setMaxNumThreads(3)
+    F = fun.map(13,"process")
+    self.checkfunction_light(F,fun.map(13),inputs=[X,P])
+    # Workers are reused across evaluations
+    self.checkfunction_light(F,fun.map(13),inputs=[2*X,P])
+    # Nested thread map, evaluated serially inside the workers
+    G = fun.map(13,"thread").map(2,"process")
+    self.checkfunction_light(G,fun.map(26),inputs=[horzcat(X,X),horzcat(P,P)])
+    F2 = Function.deserialize(F.serialize())
+    self.checkfunction_light(F2,fun.map(13),inputs=[X,P])
+    GlobalOptions.setMaxNumThreads(0)
+
+  def test_mapsum_thread(self):
+    x = SX.sym("x",2)
+    p = SX.sym("p")
+    fun = Function("f",[x,p],[sin(x)*p,sum1(x)+p,p**2])
+    X = DM(np.random.random((2,300)))
+    P = DM(np.random.random((1,1)))
+    ref = fun.map(300,[False,True],[True,False,True])
+    res = None
+    for n in [1,2,5]:
+      GlobalOptions.setMaxNumThreads(n)
+      F = fun.map(300,"thread",[False,True],[True,False,True])
+      self.checkfunction_light(F,ref,inputs=[X,P])
+      # Bit-for-bit identical for any number of threads
+      r = F(X,P)
+      if res is None: res = r
+      for a,b in zip(r,res):
+        self.assertTrue(np.all(np.array(a)==np.array(b)))
+    GlobalOptions.setMaxNumThreads(0)
+
+  def test_map_jac_sparsity(self):
+    x = SX.sym("x",3)
+    p = SX.sym("p",Sparsity.lower(2))
+    fun = Function("f",[x,p],[vertcat(x[0]*p[0],x[2]*x[1],p[1,0]),mtimes(p,x[:2])])
+    n = 5
+    F = fun.map(n)
+    Fu = fun.map(n,"unroll")
+    for i in range(2):
+      for o in range(2):
+        self.assertTrue(F.sparsity_jac(i,o)==Fu.sparsity_jac(i,o))
+    for ri in itertools.product([False,True],repeat=2):
+      for ro in itertools.product([False,True],repeat=2):
+        M = fun.map(n,list(ri),list(ro))
+        arg = M.mx_in()
+        res = Fu(*[repmat(a,1,n) if r else a for a,r in zip(arg,ri)])
+        res = [repsum(e,1,n) if r else e for e,r in zip(res,ro)]
+        R = Function("R",arg,res)
+        for i in range(2):
+          for o in range(2):
+            self.assertTrue(M.sparsity_jac(i,o)==R.sparsity_jac(i,o))
+
   @memory_heavy()
   def test_mapsum(self):
     x = SX.sym("x")
@@ -673,6 +827,158 @@ class Functiontests(casadiTestCase):
           for f in [F,toSX_fun(F)]:
             self.checkfunction(f,Fref,inputs=inputs,sparsity_mod=args.run_slow)
 
+  def test_call_batch(self):
+    x = SX.sym("x",2)
+    p = SX.sym("p")
+    y = MX.sym("y",2)
+    q = MX.sym("q")
+    GlobalOptions.setMaxNumThreads(3)
+    for fun in [Function("f",[x,p],[sin(x)*p,sum1(x)+p]), Function("f",[y,q],[sin(y)*q,sum1(y)+q])]:
+      for N in [1,5,130]:
+        X = DM(np.random.random((2,N)))
+        P = DM(np.random.random((1,N)))
+        for parallelization in ["serial","thread"]:
+          ref = fun.map(N)(X,P)
+          res = fun.call_batch([X,P],parallelization)
+          for r,e in zip(res,ref):
+            self.checkarray(r,e,digits=14)
+          # Shared input
+          ref = fun.map(N)(X,0.3)
+          res = fun.call_batch([X,0.3],parallelization)
+          for r,e in zip(res,ref):
+            self.checkarray(r,e,digits=14)
+          res = fun.call_batch({"i0":X,"i1":P},parallelization)
+          self.checkarray(res["o1"],fun.map(N)(X,P)[1],digits=14)
+    with self.assertInException("Inconsistent batch size"):
+      fun.call_batch([DM.ones(2,3),DM.ones(1,4)])
+    GlobalOptions.setMaxNumThreads(0)
+
+  def test_codegen_batch(self):
+    x = SX.sym("x",2)
+    p = SX.sym("p")
+    f = Function("f",[x,p],[sin(x)*p,sum1(x)+p])
+    c = CodeGenerator('me',{"with_batch":True})
+    c.add(f)
+    code = c.dump()
+    self.assertTrue("f_batch" in code)
+    self.assertTrue("#pragma omp simd" in code)
+
+    if args.run_slow:
+      import ctypes
+      lib = ctypes.CDLL(self.compile_codegen(c))
+      ptr = ctypes.POINTER(ctypes.c_double)
+      lib.f_batch.argtypes = [ctypes.POINTER(ptr), ctypes.POINTER(ptr), ctypes.c_longlong]
+      for N in [1,3,8]:
+        X = DM.rand(2,N)
+        P = DM.rand(1,N)
+        # Nonzero k of evaluation j at index k*N+j
+        arg_data = [np.ascontiguousarray(np.array(X).ravel()),np.ascontiguousarray(np.array(P).ravel())]
+        res_data = [np.zeros(2*N),np.zeros(N)]
+        arg = (ptr*2)(*[a.ctypes.data_as(ptr) for a in arg_data])
+        res = (ptr*2)(*[r.ctypes.data_as(ptr) for r in res_data])
+        self.assertEqual(lib.f_batch(arg,res,N),0)
+        ref = f.map(N)(X,P)
+        self.checkarray(DM(res_data[0].reshape((2,N))),ref[0],digits=15)
+        self.checkarray(DM(res_data[1].reshape((1,N))),ref[1],digits=15)
+      # Missing outputs are rejected
+      res = (ptr*2)(res_data[0].ctypes.data_as(ptr),None)
+      self.assertEqual(lib.f_batch(arg,res,N),1)
+
+    y = MX.sym("y")
+    c = CodeGenerator('me',{"with_batch":True})
+    c.add(Function("g",[y],[sin(y)]))
+    self.assertFalse("g_batch" in c.dump())
+
+  def test_codegen_split(self):
+    x = SX.sym("x",3)
+    p = SX.sym("p")
+    y = x
+    for i in range(10):
+      y = sin(y)*p+fmax(y,1)**2
+    f = Function("f",[x,p],[y,sum1(y)*p])
+    for opts in [{"split_size":7},{"split_size":7,"avoid_stack":True}]:
+      c = CodeGenerator('me',opts)
+      c.add(f)
+      self.assertTrue("f0_p0" in c.dump())
+      self.check_codegen(f,inputs=[DM([1.1,0.3,-2]),0.7],opts=opts)
+
+  def test_codegen_reroll(self):
+    x = SX.sym("x",20)
+    p = SX.sym("p",3)
+    J = 0
+    g = []
+    for k in range(19):
+      J += sin(x[k])*p[0]+(x[k+1]-x[k])**2*p[1]+fmax(x[k],0.5)
+      g.append(x[k+1]-x[k]*p[2])
+    inputs = [DM(np.linspace(-0.7,1.2,20)),DM([0.3,1.7,0.9])]
+    for live_variables in [True, False]:
+      f = Function("f",[x,p],[J,vertcat(*g)],{"live_variables":live_variables})
+      c = CodeGenerator('me',{"reroll":8})
+      c.add(f)
+      self.assertTrue("for (i=0; i<19; ++i)" in c.dump())
+      if args.run_slow:
+        # Evaluate the rerolled code
+        F = external("f",self.compile_codegen(c))
+        for r,e in zip(F.call(inputs),f.call(inputs)):
+          self.checkarray(r,e,digits=15)
+      self.check_codegen(f,inputs=inputs,opts={"reroll":8})
+
+  def test_codegen_blas(self):
+    A = MX.sym("A",5,5)
+    B = MX.sym("B",5,3)
+    x = MX.sym("x",5)
+    y = MX.sym("y",5)
+    f = Function("f",[A,B,x,y],[mtimes(A,B),mtimes(A,x),dot(x,y),bilin(A,x,y),rank1(A,0.7,x,y),solve(A+10*MX.eye(5),B)])
+    c = CodeGenerator('me',{"blas_threshold":4})
+    c.add(f)
+    s = c.dump()
+    for call in ["cblas_dgemm","cblas_dgemv","cblas_ddot","cblas_dger","LAPACKE_dgetrf","LAPACKE_dgetrs"]:
+      self.assertTrue(call in s)
+    self.assertTrue("#ifdef CASADI_WITH_CBLAS" in s)
+    c = CodeGenerator('me',{"blas_threshold":1000})
+    c.add(f)
+    self.assertFalse("cblas" in c.dump())
+    self.check_codegen(f,inputs=[DM.rand(5,5),DM.rand(5,3),DM.rand(5),DM.rand(5)],opts={"blas_threshold":4})
+    # LAPACKE scratch is only reserved in generated code
+    A = MX.sym("A",200,200)
+    b = MX.sym("b",200)
+    f = Function("f",[A,b],[solve(A,b,"qr")])
+    self.assertTrue(f.sz_w()<=A.nnz()+3*b.nnz())
+
+  def test_codegen_mixed_precision(self):
+    A = MX.sym("A",Sparsity.banded(5,1))
+    b = MX.sym("b",5)
+    f = Function("f",[A,b],[solve(A,b,"qr"),solve(A,b,"ldl")])
+    # Widened copies are only reserved in generated code
+    self.assertEqual(f.sz_w(),Function("f",[A,b],[solve(A,b,"symbolicqr"),solve(A,b,"symbolicqr")]).sz_w())
+    c = CodeGenerator('me',{"casadi_real":"float","casadi_real_solve":"double"})
+    c.add(f)
+    c.add_precision_check(f,[[DM.rand(Sparsity.banded(5,1))+3*DM.eye(5),DM.rand(5)]])
+    s = c.dump()
+    for call in ["casadi_qr_double(","casadi_qr_solve_double(","casadi_ldl_double(","casadi_dot_double(","f_precision_error(void)"]:
+      self.assertTrue(call in s)
+    self.assertFalse("casadi_qr(" in s)
+    self.assertFalse("casadi_if_else(" in s)
+    if args.run_slow:
+      import ctypes
+      lib = ctypes.CDLL(self.compile_codegen(c))
+      lib.f_precision_error.restype = ctypes.c_double
+      err = lib.f_precision_error()
+      # Single precision storage, double precision factorization
+      self.assertTrue(err>=0)
+      self.assertTrue(err<1e-4)
+    with self.assertInException("casadi_real_solve"):
+      CodeGenerator('me',{"casadi_real_solve":"long double"})
+
+  def test_codegen_benchmark(self):
+    x = SX.sym("x",3)
+    f = Function("f",[x],[sin(x)*2])
+    c = CodeGenerator('me',{"benchmark":True})
+    c.add(f)
+    s = c.dump()
+    self.assertTrue("casadi_int benchmark_f(casadi_int argc, char* argv[])" in s)
+    self.assertTrue("clock_gettime(CLOCK_MONOTONIC" in s)
+    self.check_codegen(f,inputs=[DM([1.1,0.3,-2])],opts={"benchmark":True})
 
   @memory_heavy()
   def test_mapsum2(self):
@@ -2126,6 +2432,20 @@ class Functiontests(casadiTestCase):
         self.assertTrue("[[-1e-07]," in out[0] or "[[-1e-007]," in out[0] )
         self.assertTrue("[[1e-07]," in out[0] or "[[1e-007]," in out[0] )
 
+  def test_fd_parallelization(self):
+    x = MX.sym("x",3)
+    p = MX.sym("p",2)
+    GlobalOptions.setMaxNumThreads(3)
+    for fd_method in ["forward","central","smoothing"]:
+      opts = {"enable_fd":True,"enable_forward":False,"enable_reverse":False,"fd_method":fd_method}
+      f1 = Function("f",[x,p],[sin(x)*p[0]+p[1],dot(x,x)],opts)
+      for parallelization in ["serial","thread"]:
+        opts["fd_options"] = {"parallelization":parallelization}
+        f2 = Function("f",[x,p],[sin(x)*p[0]+p[1],dot(x,x)],opts)
+        self.checkfunction_light(f1.forward(4),f2.forward(4),
+          inputs=[[0.1,0.2,0.3],[0.4,0.5]]+f1([0.1,0.2,0.3],[0.4,0.5])+[DM.ones(3,4),DM.ones(2,4)])
+    GlobalOptions.setMaxNumThreads(0)
+
   @requires_nlpsol("ipopt")
   @requiresPlugin(Importer,"shell")
   def test_inherit_jit_options(self):
@@ -2153,6 +2473,62 @@ class Functiontests(casadiTestCase):
     self.assertTrue("Q" in found)
     self.assertTrue("fwd1_Q" in found)
 
+  @requiresPlugin(Importer,"shell")
+  def test_shell_cache(self):
+    import shutil, glob
+    cache = "shell_cache_test"
+    shutil.rmtree(cache, ignore_errors=True)
+    x = SX.sym("x")
+    opts = {"jit":True,"compiler":"shell","jit_options":{"cache":cache,"cache_size":2,"verbose":True}}
+    for c in [1,2,1,3,4]:
+      f = Function('f',[x],[sin(x)*c],opts)
+      self.checkarray(f(0.5),sin(0.5)*c)
+    self.assertEqual(len(glob.glob(cache+"/casadi_*")),2)
+    with capture_stdout() as out:
+      f = Function('f',[x],[sin(x)*4],opts)
+    self.assertTrue("from cache" in out[0])
+    self.checkarray(f(0.5),sin(0.5)*4)
+    # Least recently used first, also within the same second: 2 then 1 evicted
+    with capture_stdout() as out:
+      f = Function('f',[x],[sin(x)*3],opts)
+    self.assertTrue("from cache" in out[0])
+    with capture_stdout() as out:
+      f = Function('f',[x],[sin(x)*1],opts)
+    self.assertFalse("from cache" in out[0])
+    self.checkarray(f(0.5),sin(0.5))
+    shutil.rmtree(cache, ignore_errors=True)
+
+  @requiresPlugin(Importer,"shell")
+  def test_jit_async(self):
+    x = SX.sym("x",3)
+    y = x
+    for i in range(20):
+      y = sin(y)+x
+    ref = Function('g',[x],[y])
+    self.assertEqual(ref.jit_status(),"none")
+    for threshold in [0,3]:
+      f = Function('f',[x],[y],{"jit":True,"compiler":"shell","jit_async":True,"jit_threshold":threshold})
+      self.assertTrue(f.jit_status() in ["pending","compiling","ready"])
+      for i in range(5):
+        self.checkarray(f([1,2,3]),ref([1,2,3]),digits=14)
+      self.assertTrue(f.jit_wait())
+      self.assertEqual(f.jit_status(),"ready")
+      self.checkarray(f([1,2,3]),ref([1,2,3]),digits=14)
+      # Asynchronous settings survive serialization
+      g = Function.deserialize(f.serialize())
+      if threshold>0: self.assertEqual(g.jit_status(),"pending")
+      for i in range(threshold):
+        self.checkarray(g([1,2,3]),ref([1,2,3]),digits=14)
+      self.assertTrue(g.jit_wait())
+      self.assertEqual(g.jit_status(),"ready")
+    # Serializing the library waits for a pending compilation
+    for jit_serialize in ["link","embed"]:
+      f = Function('f',[x],[y],{"jit":True,"compiler":"shell","jit_async":True,"jit_threshold":5,"jit_serialize":jit_serialize})
+      self.assertEqual(f.jit_status(),"pending")
+      g = Function.deserialize(f.serialize())
+      self.assertEqual(f.jit_status(),"ready")
+      self.checkarray(g([1,2,3]),ref([1,2,3]),digits=14)
+
   def test_custom_jacobian(self):
     x = MX.sym("x")
     p = MX.sym("p")
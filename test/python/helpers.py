@@ -576,16 +576,19 @@ class casadiTestCase(unittest.TestCase):
       if definitions is None:
         definitions = []
 
+      import glob
+      sources = " ".join([name+".c"] + sorted(glob.glob(name+"_part*.c")))
+
       def get_commands(shared=True):
         if os.name=='nt':
           defs = " ".join(["/D"+d for d in definitions])
-          commands = "cl.exe {shared} {definitions} {name}.c {extra} /link  /libpath:{libdir}".format(shared="/LD" if shared else "",std=std,name=name,libdir=libdir,includedir=includedir,extra=extralibs + extra_options + extralibs + extra_options,definitions=defs)
+          commands = "cl.exe {shared} {definitions} {sources} {extra} /link  /libpath:{libdir}".format(shared="/LD" if shared else "",std=std,sources=sources,libdir=libdir,includedir=includedir,extra=extralibs + extra_options + extralibs + extra_options,definitions=defs)
           output = "./" + name + (".dll" if shared else ".exe")
           return [commands, output]
         else:
           defs = " ".join(["-D"+d for d in definitions])
           output = "./" + name + (".so" if shared else "")
-          commands = "gcc -pedantic -std={std} -fPIC {shared} -Wall -Werror -Wextra -I{includedir} -Wno-unknown-pragmas -Wno-long-long -Wno-unused-parameter -O3 {definitions} {name}.c -o {name_out} -L{libdir}".format(shared="-shared" if shared else "",std=std,name=name,name_out=name+(".so" if shared else ""),libdir=libdir,includedir=includedir,definitions=defs) + (" -lm" if not shared else "") + extralibs + extra_options 
+          commands = "gcc -pedantic -std={std} -fPIC {shared} -Wall -Werror -Wextra -I{includedir} -Wno-unknown-pragmas -Wno-long-long -Wno-unused-parameter -O3 {definitions} {sources} -o {name_out} -L{libdir}".format(shared="-shared" if shared else "",std=std,sources=sources,name_out=name+(".so" if shared else ""),libdir=libdir,includedir=includedir,definitions=defs) + (" -lm" if not shared else "") + extralibs + extra_options 
           return [commands, output]
 
       [commands, libname] = get_commands(shared=True)
@@ -628,6 +631,29 @@ class casadiTestCase(unittest.TestCase):
       if self.check_serialize:
         self.check_serialize(F2,inputs=inputs)
 
+  def compile_codegen(self,c,definitions=None):
+    """Compile the code of a CodeGenerator to a shared library, returns its path"""
+    import tempfile
+    import subprocess
+    import glob
+    prefix = tempfile.mkdtemp() + os.sep
+    source = c.generate(prefix)
+    name = source[:-2]
+    sources = " ".join([source] + sorted(glob.glob(name+"_part*.c")))
+    if definitions is None:
+      definitions = []
+    if os.name=='nt':
+      defs = " ".join(["/D"+d for d in definitions])
+      libname = name + ".dll"
+      commands = "cl.exe /LD {definitions} {sources} /Fe{libname}".format(definitions=defs,sources=sources,libname=libname)
+    else:
+      defs = " ".join(["-D"+d for d in definitions])
+      libname = name + ".so"
+      commands = "gcc -pedantic -std=c89 -fPIC -shared -Wall -Werror -Wextra -Wno-unknown-pragmas -Wno-long-long -Wno-unused-parameter -O3 {definitions} {sources} -o {libname}".format(definitions=defs,sources=sources,libname=libname)
+    print(commands)
+    self.assertEqual(subprocess.Popen(commands,shell=True).wait(),0)
+    return libname
+
   def check_thread_safety(self,F,inputs=None,N=20):
     
     FP = F.map(N, 'thread',2)